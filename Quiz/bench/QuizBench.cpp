@@ -0,0 +1,632 @@
+/****************************************************************************
+** Copyright (c) 2023, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+#include <QtCore/QDateTime>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QSaveFile>
+#include <QtCore/QSysInfo>
+#include <QtCore/QTemporaryDir>
+#include <QtCore/QXmlStreamReader>
+#include <QtGui/QImageWriter>
+#include <QtGui/QPixmap>
+#include <QtGui/QTransform>
+#include <QtTest/QtTest>
+#include <QtWidgets/QApplication>
+#include <QtWidgets/QListView>
+#include <QtXml/QDomDocument>
+
+#include "Corpus.h"
+#include "Data.h"
+#include "DocumentCache.h"
+#include "Image.h"
+#include "ImageCache.h"
+#include "ImageLoader.h"
+#include "QuestionsModel.h"
+#include "Util.h"
+#include "WImageViewer.h"
+#include "WQuestion.h"
+
+////// Private ///////////////////////////////////////////////////////////////
+
+namespace priv {
+
+  Quiz makeQuiz(const int questions, const int words)
+  {
+    Corpus corpus;
+    corpus.images    = 0;
+    corpus.questions = questions;
+    corpus.words     = words;
+    return corpus.makeQuiz();
+  }
+
+  QString domText(const QDomElement& parent, const QString& tag)
+  {
+    const QString text = parent.firstChildElement(tag).text();
+
+    constexpr QChar LF = QChar::fromLatin1('\n');
+    if( !text.contains(LF) ) {
+      return text.trimmed();
+    }
+
+    QStringList lines = text.split(LF, QString::SkipEmptyParts);
+    for( QString& line : lines ) {
+      line = line.trimmed();
+    }
+    return lines.join(LF);
+  }
+
+  Quiz readDom(const QString& filename)
+  {
+    QFile file(filename);
+    if( !file.open(QIODevice::ReadOnly) ) {
+      return Quiz();
+    }
+
+    QDomDocument doc;
+    if( !doc.setContent(&file) ) {
+      return Quiz();
+    }
+
+    const QDomElement xml_quiz = doc.firstChildElement(QStringLiteral("quiz"));
+    if( xml_quiz.isNull() ) {
+      return Quiz();
+    }
+
+    Quiz result(xml_quiz.firstChildElement(QStringLiteral("solution")).text());
+    if( result.isEmpty() ) {
+      return Quiz();
+    }
+
+    bool ok         = false;
+    result.fontSize = xml_quiz.attribute(QStringLiteral("font_size")).toInt(&ok);
+    if( !ok ) {
+      result.fontSize = DEFAULT_FONTSIZE;
+    }
+
+    const QDir dir = QFileInfo(filename).absoluteDir();
+
+    auto it = result.questions.begin();
+    for( QDomElement xml_question = xml_quiz.firstChildElement(QStringLiteral("question"));
+         !xml_question.isNull() && it != result.questions.end();
+         xml_question = xml_question.nextSiblingElement(QStringLiteral("question")), ++it ) {
+      it->answer   = domText(xml_question, QStringLiteral("answer"));
+      it->category = domText(xml_question, QStringLiteral("category"));
+      it->question = domText(xml_question, QStringLiteral("question"));
+
+      for( QDomElement xml_image = xml_question.firstChildElement(QStringLiteral("image"));
+           !xml_image.isNull();
+           xml_image = xml_image.nextSiblingElement(QStringLiteral("image")) ) {
+        const QFileInfo info(dir, xml_image.text());
+        if( !info.exists() ) {
+          continue;
+        }
+
+        Image image;
+        image.bgColor = xml_image.attribute(QStringLiteral("bg"));
+        image.flipH   = xml_image.attribute(QStringLiteral("flip_h")) == QLatin1String("true");
+        image.flipV   = xml_image.attribute(QStringLiteral("flip_v")) == QLatin1String("true");
+        image.path    = info.absoluteFilePath();
+        image.rotate  = xml_image.attribute(QStringLiteral("rotate")).toInt();
+        it->images.push_back(image);
+      }
+    }
+
+    return result;
+  }
+
+  QImage makePattern(const QSize& size)
+  {
+    QImage result(size, QImage::Format_RGB32);
+    for( int y = 0; y < size.height(); y++ ) {
+      for( int x = 0; x < size.width(); x++ ) {
+        result.setPixel(x, y, qRgb(x & 0xFF, y & 0xFF, (x * 7 + y * 13) & 0xFF));
+      }
+    }
+    return result;
+  }
+
+  QImage rotatedMatrix(const QImage& image, const int angle)
+  {
+    qreal COS{1}, SIN{0};
+
+    if(        angle ==  90 ) {
+      COS = 0;
+      SIN = 1;
+    } else if( angle == 180 ) {
+      COS = -1;
+      SIN =  0;
+    } else if( angle == 270 ) {
+      COS =  0;
+      SIN = -1;
+    }
+
+    const QTransform matrix{COS, -SIN,
+                            SIN, COS,
+                            0, 0};
+    return image.transformed(matrix, Qt::SmoothTransformation);
+  }
+
+  QString sizeTag(const QSize& size)
+  {
+    return QStringLiteral("%1x%2").arg(size.width()).arg(size.height());
+  }
+
+  QJsonArray readResults(const QString& filename)
+  {
+    QFile file(filename);
+    if( !file.open(QIODevice::ReadOnly) ) {
+      return QJsonArray();
+    }
+
+    QJsonArray results;
+    QString function;
+    QXmlStreamReader xml(&file);
+    while( !xml.atEnd() ) {
+      if( xml.readNext() != QXmlStreamReader::StartElement ) {
+        continue;
+      }
+
+      const QXmlStreamAttributes attrs = xml.attributes();
+      if(        xml.name() == QLatin1String("TestFunction") ) {
+        function = attrs.value(QStringLiteral("name")).toString();
+      } else if( xml.name() == QLatin1String("BenchmarkResult") ) {
+        QJsonObject result;
+        result.insert(QStringLiteral("name"), function);
+        result.insert(QStringLiteral("tag"), attrs.value(QStringLiteral("tag")).toString());
+        result.insert(QStringLiteral("metric"), attrs.value(QStringLiteral("metric")).toString());
+        result.insert(QStringLiteral("value"), attrs.value(QStringLiteral("value")).toDouble());
+        result.insert(QStringLiteral("iterations"), attrs.value(QStringLiteral("iterations")).toInt());
+        results.push_back(result);
+      }
+    }
+
+    return results;
+  }
+
+} // namespace priv
+
+////// QuizBench /////////////////////////////////////////////////////////////
+
+class QuizBench : public QObject {
+  Q_OBJECT
+private slots:
+  void initTestCase();
+
+  void read_data();
+  void read();
+  void solve_data();
+  void solve();
+  void imageLoad_data();
+  void imageLoad();
+  void rotated_data();
+  void rotated();
+  void transformed_data();
+  void transformed();
+  void viewerPaint_data();
+  void viewerPaint();
+  void modelData();
+  void modelView();
+  void questionOpen_data();
+  void questionOpen();
+
+private:
+  QString filePath(const QString& name) const;
+  QString imageFile(const QSize& size, const QByteArray& format) const;
+
+  QTemporaryDir _dir{};
+};
+
+void QuizBench::initTestCase()
+{
+  QVERIFY(_dir.isValid());
+}
+
+void QuizBench::read_data()
+{
+  QTest::addColumn<int>("count");
+  QTest::addColumn<int>("words");
+  QTest::addColumn<bool>("dom");
+
+  QTest::newRow("small dom")    << 26   << 10  << true;
+  QTest::newRow("small stream") << 26   << 10  << false;
+  QTest::newRow("huge dom")     << 5000 << 400 << true;
+  QTest::newRow("huge stream")  << 5000 << 400 << false;
+}
+
+void QuizBench::read()
+{
+  QFETCH(int, count);
+  QFETCH(int, words);
+  QFETCH(bool, dom);
+
+  const QString filename = filePath(QStringLiteral("read-%1-%2.xml").arg(count).arg(words));
+  if( !QFile::exists(filename) ) {
+    QVERIFY(priv::makeQuiz(count, words).write(filename));
+  }
+
+  const Quiz expected = priv::readDom(filename);
+  const Quiz quiz     = Quiz::read(filename);
+  QCOMPARE(quiz.questions.size(), count);
+  QCOMPARE(quiz.solution, expected.solution);
+  QCOMPARE(quiz.questions.front().answer, expected.questions.front().answer);
+  QCOMPARE(quiz.questions.back().question, expected.questions.back().question);
+
+  if( dom ) {
+    QBENCHMARK {
+      const Quiz result = priv::readDom(filename);
+    }
+  } else {
+    QBENCHMARK {
+      const Quiz result = Quiz::read(filename);
+    }
+  }
+}
+
+void QuizBench::solve_data()
+{
+  QTest::addColumn<int>("count");
+
+  QTest::newRow("small") << 26;
+  QTest::newRow("huge")  << 5000;
+}
+
+void QuizBench::solve()
+{
+  QFETCH(int, count);
+
+  Quiz quiz = priv::makeQuiz(count, 1);
+  const QString letters = quiz.letters;
+
+  QBENCHMARK {
+    quiz.reset();
+    for( const QChar& c : letters ) {
+      quiz.solve(c);
+    }
+  }
+
+  QCOMPARE(quiz.displayText, quiz.solution);
+}
+
+void QuizBench::imageLoad_data()
+{
+  QTest::addColumn<QByteArray>("format");
+  QTest::addColumn<QSize>("size");
+  QTest::addColumn<QSize>("target");
+
+  const QList<QByteArray> supported = QImageWriter::supportedImageFormats();
+  for( const QByteArray& format : {QByteArrayLiteral("png"), QByteArrayLiteral("jpg"), QByteArrayLiteral("bmp")} ) {
+    if( !supported.contains(format) ) {
+      continue;
+    }
+    for( const QSize& size : {QSize(1280, 720), QSize(3840, 2160)} ) {
+      const QString tag = QStringLiteral("%1 %2").arg(QString::fromLatin1(format), priv::sizeTag(size));
+      QTest::newRow(qPrintable(tag + QStringLiteral(" full")))   << format << size << QSize();
+      QTest::newRow(qPrintable(tag + QStringLiteral(" screen"))) << format << size << QSize(1920, 1080);
+    }
+  }
+}
+
+void QuizBench::imageLoad()
+{
+  QFETCH(QByteArray, format);
+  QFETCH(QSize, size);
+  QFETCH(QSize, target);
+
+  Image image;
+  image.path = imageFile(size, format);
+  QVERIFY(!image.load(target).isNull());
+
+  QBENCHMARK {
+    ImageCache::instance().clear();
+    const QImage loaded = image.load(target);
+  }
+}
+
+void QuizBench::rotated_data()
+{
+  QTest::addColumn<int>("angle");
+  QTest::addColumn<bool>("baseline");
+
+  for( const int angle : {0, 90, 180, 270} ) {
+    QTest::newRow(qPrintable(QStringLiteral("%1 matrix").arg(angle))) << angle << true;
+    QTest::newRow(qPrintable(QStringLiteral("%1 kernel").arg(angle))) << angle << false;
+  }
+}
+
+void QuizBench::rotated()
+{
+  QFETCH(int, angle);
+  QFETCH(bool, baseline);
+
+  const QImage image = Corpus::makeImage(QSize(3840, 2160), 1);
+
+  const QImage expected = image
+                            .transformed(QTransform().rotate(-angle))
+                            .convertToFormat(image.format());
+  QCOMPARE(util::rotated(image, angle), expected);
+
+  if( baseline ) {
+    QBENCHMARK {
+      const QImage result = priv::rotatedMatrix(image, angle);
+    }
+  } else {
+    QBENCHMARK {
+      const QImage result = util::rotated(image, angle);
+    }
+  }
+}
+
+void QuizBench::transformed_data()
+{
+  QTest::addColumn<QSize>("size");
+  QTest::addColumn<int>("angle");
+  QTest::addColumn<bool>("flipH");
+  QTest::addColumn<bool>("flipV");
+
+  for( const QSize& size : {QSize(67, 37), QSize(1, 37), QSize(37, 1), QSize(1, 1)} ) {
+    for( const int angle : {0, 90, 180, 270} ) {
+      for( int flips = 0; flips < 4; flips++ ) {
+        const bool flipH = (flips & 1) != 0;
+        const bool flipV = (flips & 2) != 0;
+
+        const QString tag = QStringLiteral("%1 %2%3%4")
+                              .arg(priv::sizeTag(size))
+                              .arg(angle)
+                              .arg(flipH ? QStringLiteral(" flip_h") : QString())
+                              .arg(flipV ? QStringLiteral(" flip_v") : QString());
+        QTest::newRow(qPrintable(tag)) << size << angle << flipH << flipV;
+      }
+    }
+  }
+}
+
+void QuizBench::transformed()
+{
+  QFETCH(QSize, size);
+  QFETCH(int, angle);
+  QFETCH(bool, flipH);
+  QFETCH(bool, flipV);
+
+  const QImage image = priv::makePattern(size);
+
+  const QImage expected = image
+                            .mirrored(flipH, flipV)
+                            .transformed(QTransform().rotate(-angle))
+                            .convertToFormat(image.format());
+  QCOMPARE(util::transformed(image, angle, flipH, flipV), expected);
+}
+
+void QuizBench::viewerPaint_data()
+{
+  QTest::addColumn<QSize>("size");
+  QTest::addColumn<bool>("smooth");
+
+  const QSize display = WImageViewer::displaySize();
+  QTest::newRow("window fast")       << display / 2 << false;
+  QTest::newRow("window smooth")     << display / 2 << true;
+  QTest::newRow("fullscreen fast")   << display     << false;
+  QTest::newRow("fullscreen smooth") << display     << true;
+}
+
+void QuizBench::viewerPaint()
+{
+  QFETCH(QSize, size);
+  QFETCH(bool, smooth);
+
+  Image image;
+  image.path = imageFile(QSize(3840, 2160), QByteArrayLiteral("png"));
+
+  WImageViewer viewer(Images{image});
+  if( smooth ) {
+    viewer.setSmoothDelay(0);
+  }
+  QVERIFY(QTest::qWaitFor([]() -> bool { return !ImageLoader::isBusy(); }));
+
+  QImage target(size, QImage::Format_RGB32);
+  const QSize other = size - QSize(1, 1);
+  bool flip = false;
+
+  QBENCHMARK {
+    viewer.resize(flip ? other : size);
+    viewer.render(&target);
+    flip = !flip;
+  }
+}
+
+void QuizBench::modelData()
+{
+  const Quiz quiz = priv::makeQuiz(5000, 40);
+
+  QuestionsModel model;
+  model.setQuestions(quiz);
+
+  QListView view;
+  view.setModel(&model);
+  view.show();
+  QVERIFY(QTest::qWaitForWindowExposed(&view));
+
+  const int rows = model.rowCount();
+  const int roles[] = {
+    Qt::DisplayRole, Qt::DecorationRole, Qt::ToolTipRole, Qt::FontRole, Qt::TextAlignmentRole
+  };
+
+  int valid = 0;
+  QBENCHMARK {
+    for( int row = 0; row < rows; row++ ) {
+      const QModelIndex index = model.index(row);
+      for( const int role : roles ) {
+        if( model.data(index, role).isValid() ) {
+          valid++;
+        }
+      }
+    }
+  }
+
+  QVERIFY(valid > 0);
+}
+
+void QuizBench::modelView()
+{
+  const Quiz quiz = priv::makeQuiz(5000, 40);
+
+  QuestionsModel model;
+  model.setQuestions(quiz);
+
+  QListView view;
+  view.setViewMode(QListView::IconMode);
+  view.setModel(&model);
+  view.resize(1280, 720);
+  view.show();
+  QVERIFY(QTest::qWaitForWindowExposed(&view));
+
+  QBENCHMARK {
+    view.viewport()->repaint();
+  }
+}
+
+void QuizBench::questionOpen_data()
+{
+  QTest::addColumn<bool>("prepared");
+
+  QTest::newRow("on demand") << false;
+  QTest::newRow("prepared")  << true;
+}
+
+void QuizBench::questionOpen()
+{
+  QFETCH(bool, prepared);
+
+  const Quiz quiz = priv::makeQuiz(26, 2000);
+
+  DocumentCache docs;
+
+  WQuestion dialog;
+  dialog.resize(800, 600);
+  docs.setTextWidth(dialog.textWidth());
+  docs.setQuiz(quiz);
+
+  if( prepared ) {
+    for( const Question& q : quiz.questions ) {
+      docs.question(q);
+      docs.answer(q);
+    }
+  }
+
+  int no = 0;
+  QBENCHMARK {
+    const Question& q = quiz.questions.at(no++ % quiz.questions.size());
+    if( !prepared ) {
+      docs.setQuiz(quiz);
+    }
+
+    dialog.setQuestion(q, &docs);
+    dialog.show();
+    const QPixmap frame = dialog.grab();
+    dialog.done(QDialog::Rejected);
+  }
+}
+
+QString QuizBench::filePath(const QString& name) const
+{
+  return _dir.filePath(name);
+}
+
+QString QuizBench::imageFile(const QSize& size, const QByteArray& format) const
+{
+  const QString filename = filePath(QStringLiteral("image-%1.%2")
+                                    .arg(priv::sizeTag(size), QString::fromLatin1(format)));
+  if( !QFile::exists(filename) ) {
+    Corpus::makeImage(size, 1).save(filename, format.constData());
+  }
+  return filename;
+}
+
+////// main //////////////////////////////////////////////////////////////////
+
+int main(int argc, char **argv)
+{
+  if( !qEnvironmentVariableIsSet("QT_QPA_PLATFORM") ) {
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+  }
+
+  QApplication app(argc, argv);
+
+  // (1) Arguments; "-json <file>" is ours, everything else is Qt Test's /////
+
+  QStringList args = QApplication::arguments();
+
+  QString output = QStringLiteral("QuizBench.json");
+  const int at = args.indexOf(QStringLiteral("-json"));
+  if( at > 0 && at + 1 < args.size() ) {
+    output = args[at + 1];
+    args.erase(args.begin() + at, args.begin() + at + 2);
+  }
+
+  QTemporaryDir logDir;
+  const QString log = logDir.filePath(QStringLiteral("QuizBench.xml"));
+  args << QStringLiteral("-o") << log + QStringLiteral(",xml")
+       << QStringLiteral("-o") << QStringLiteral("-,txt");
+
+  // (2) Run /////////////////////////////////////////////////////////////////
+
+  QuizBench bench;
+  const int result = QTest::qExec(&bench, args);
+
+  // (3) Results /////////////////////////////////////////////////////////////
+
+  QJsonObject root;
+  root.insert(QStringLiteral("arch"), QSysInfo::currentCpuArchitecture());
+  root.insert(QStringLiteral("os"), QSysInfo::prettyProductName());
+  root.insert(QStringLiteral("qt"), QString::fromLatin1(qVersion()));
+  root.insert(QStringLiteral("results"), priv::readResults(log));
+  root.insert(QStringLiteral("timestamp"), QDateTime::currentDateTimeUtc().toString(Qt::ISODate));
+
+  QSaveFile file(output);
+  if( !file.open(QIODevice::WriteOnly)
+      || file.write(QJsonDocument(root).toJson()) < 0
+      || !file.commit() ) {
+    std::fprintf(stderr, "%s: %s\n", qPrintable(output), qPrintable(file.errorString()));
+    return EXIT_FAILURE;
+  }
+
+  return result;
+}
+
+#include "QuizBench.moc"
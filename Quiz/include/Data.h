@@ -31,12 +31,20 @@
 
 #pragma once
 
+#include <functional>
+
 #include <QStringList>
+#include <QVector>
 
 #include "Image.h"
 
+class QIODevice;
+
 constexpr int DEFAULT_FONTSIZE = 32;
 
+using ImageNameFunc    = std::function<QString(const Image& image)>;
+using ImageResolveFunc = std::function<bool(Image& image, const QString& name)>;
+
 struct Question {
   Question() = default;
 
@@ -54,15 +62,25 @@ struct Quiz {
 
   bool isEmpty() const;
 
+  void indexLetters();
   void reset();
-  QString solve(const QChar& c);
-  void write(const QString& filename) const;
+  QString solve(const QChar& c, QVector<int> *changed = nullptr);
+  bool write(const QString& filename) const;
+  bool write(QIODevice *device, const ImageNameFunc& imageName) const;
+  bool writeCompiled(const QString& filename, const QString& source) const;
+  bool writePack(const QString& filename, QString *errmsg = nullptr) const;
 
-  static Quiz read(const QString& filename);
+  static Quiz load(const QString& filename, QString *errmsg = nullptr);
+  static Quiz read(const QString& filename, QString *errmsg = nullptr);
+  static Quiz read(QIODevice *device, const QString& filename,
+                   const ImageResolveFunc& resolve, QString *errmsg = nullptr);
+  static Quiz readCompiled(const QString& filename, QString *errmsg = nullptr);
+  static Quiz readPack(const QString& filename, QString *errmsg = nullptr);
 
   QString displayText{};
   int fontSize{DEFAULT_FONTSIZE};
   QString letters{};
+  QList<QVector<int>> letterPositions{};
   QList<Question> questions{};
   QString solution{};
 };
@@ -0,0 +1,76 @@
+/****************************************************************************
+** Copyright (c) 2023, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#pragma once
+
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QObject>
+
+#include "Data.h"
+
+class QTextDocument;
+class QTimer;
+
+class DocumentCache : public QObject {
+  Q_OBJECT
+public:
+  DocumentCache(QObject *parent = nullptr);
+  ~DocumentCache();
+
+  QTextDocument *answer(const Question& q);
+  QTextDocument *question(const Question& q);
+  void setQuiz(const Quiz& quiz);
+  void setTextWidth(const qreal width);
+  void updateQuiz(const Quiz& quiz);
+
+private slots:
+  void prepareNext();
+
+private:
+  struct Entry {
+    QString answerHtml{};
+    QString questionHtml{};
+    QTextDocument *answer{nullptr};
+    QTextDocument *question{nullptr};
+  };
+
+  void clear();
+  QTextDocument *document(QTextDocument *& doc, const QString& html);
+  Entry& entry(const Question& q);
+  void layout(QTextDocument *doc) const;
+
+  QHash<QChar, Entry> _entries{};
+  int _fontSize{DEFAULT_FONTSIZE};
+  QList<QChar> _queue{};
+  qreal _textWidth{-1};
+  QTimer *_timer{nullptr};
+};
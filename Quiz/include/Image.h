@@ -32,22 +32,31 @@
 #pragma once
 
 #include <list>
+#include <memory>
 
+#include <QtCore/QSize>
 #include <QtCore/QString>
 
 class QImage;
 
+class QuizPack;
+
 struct Image {
   Image() noexcept;
 
+  bool canLoad() const;
   bool exists() const;
 
   QString fileName() const;
-  QImage load() const;
+  QImage load(const QSize& targetSize = QSize()) const;
+  bool refresh();
 
   QString bgColor{QStringLiteral("#000000")};
+  qint64 fileSize{-1}; // Cached; -1 if unknown
+  qint64 fileTime{-1}; // Cached msecs since epoch; -1 if unknown
   bool flipH{false};
   bool flipV{false};
+  std::shared_ptr<const QuizPack> pack{}; // Holds the image's data if set
   QString path{};
   int rotate{0};
 };
@@ -0,0 +1,93 @@
+/****************************************************************************
+** Copyright (c) 2023, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#pragma once
+
+#include <memory>
+
+#include <QtCore/QByteArray>
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QSize>
+#include <QtCore/QString>
+#include <QtGui/QImage>
+
+class ImageCache {
+public:
+  struct Key {
+    QString path{};
+    qint64 mtime{0};
+    int rotate{0};
+    bool flipH{false};
+    bool flipV{false};
+    QSize size{};
+
+    bool operator==(const Key& other) const;
+  };
+
+  struct Stats {
+    qint64 encodedBudget{0};
+    qint64 encodedBytes{0};
+    quint64 encodedEvictions{0};
+    quint64 encodedHits{0};
+    quint64 encodedMisses{0};
+    qint64 decodedBudget{0};
+    qint64 decodedBytes{0};
+    quint64 decodedEvictions{0};
+    quint64 decodedHits{0};
+    quint64 decodedMisses{0};
+  };
+
+  ~ImageCache();
+
+  void clear();
+  void evict(const QString& path);
+  Stats stats() const;
+  void setBudgets(const qint64 encodedBytes, const qint64 decodedBytes);
+
+  QImage decoded(const Key& key);
+  QByteArray encoded(const QString& path, const qint64 mtime);
+
+  void insertDecoded(const Key& key, const QImage& image);
+  void insertEncoded(const QString& path, const qint64 mtime, const QByteArray& data);
+
+  static ImageCache& instance();
+
+private:
+  ImageCache();
+
+  struct Tiers;
+
+  mutable QMutex _mutex{};
+  std::unique_ptr<Tiers> _tiers{};
+};
+
+uint qHash(const ImageCache::Key& key, uint seed = 0);
@@ -0,0 +1,76 @@
+/****************************************************************************
+** Copyright (c) 2023, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#pragma once
+
+#include <QtCore/QAtomicInteger>
+#include <QtCore/QHash>
+#include <QtCore/QObject>
+#include <QtCore/QSize>
+#include <QtCore/QThreadPool>
+
+#include "Image.h"
+
+class QImage;
+
+class ImageLoader : public QObject {
+  Q_OBJECT
+public:
+  ImageLoader(QObject *parent = nullptr);
+  ~ImageLoader();
+
+  bool isPending(const int id) const;
+  void request(const int id, const Image& image, const int priority = 0);
+  void setTargetSize(const QSize& size);
+  void setWindow(const int first, const int last);
+
+  static bool isBusy();
+  static void waitForIdle(const QAtomicInt& canceled);
+  static void wakeWaiting();
+
+signals:
+  void loaded(int id, const QImage& image);
+
+private:
+  struct Request {
+    Image image{};
+    int priority{0};
+  };
+
+  void finish(const int id, const QImage& image, const bool skipped);
+  bool isWanted(const int id) const;
+  void start(const int id, const Request& req);
+
+  QHash<int, Request> _pending{};
+  QThreadPool _pool{};
+  QSize _targetSize{};
+  QAtomicInteger<quint64> _window{};
+};
@@ -0,0 +1,75 @@
+/****************************************************************************
+** Copyright (c) 2023, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#pragma once
+
+#include <QtCore/QFile>
+#include <QtCore/QList>
+#include <QtCore/QString>
+
+struct Quiz;
+
+class Journal {
+public:
+  enum Action : quint16 {
+    Reveal = 1,
+    Answer = 2
+  };
+
+  enum Sync : int {
+    SyncNone = 0, // Survives crashes of the application; costs a write()
+    SyncAlways    // Survives crashes of the system; costs a write() & fsync()
+  };
+
+  struct Entry {
+    Action action{Reveal};
+    QChar letter{};
+    qint64 time{0}; // msecs since epoch
+  };
+
+  Journal() = default;
+  ~Journal();
+
+  void close();
+  bool isOpen() const;
+  bool open(const QString& quizFile, const Quiz& quiz, const bool resume);
+  bool record(const Action action, const QChar& letter);
+  bool remove();
+  void setSync(const Sync sync);
+
+  static QString fileName(const QString& quizFile);
+  static QList<Entry> read(const QString& quizFile, const Quiz& quiz);
+
+private:
+  QFile _file{};
+  quint32 _sequence{0};
+  Sync _sync{SyncNone};
+};
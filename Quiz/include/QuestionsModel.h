@@ -33,9 +33,15 @@
 #define QUESTIONSMODEL_H
 
 #include <QtCore/QAbstractListModel>
+#include <QtCore/QHash>
+#include <QtCore/QSet>
+#include <QtCore/QVector>
 
 #include "data.h"
 
+class DocumentCache;
+class WQuestion;
+
 class QuestionsModel : public QAbstractListModel {
   Q_OBJECT
 public:
@@ -46,16 +52,45 @@ public:
   Qt::ItemFlags flags(const QModelIndex& index) const;
   int rowCount(const QModelIndex& parent = QModelIndex()) const;
 
+  QSet<QChar> answeredLetters() const;
+  bool isAnswered(const int row) const;
+  void setAnswered(const int row);
+  void setAnsweredLetter(const QChar& c);
+  bool keepAnswered() const;
+  void setDocumentCache(DocumentCache *docs);
+  void setQuestionDialog(WQuestion *dialog);
+  void setKeepAnswered(const bool on);
   void setQuestions(const Quiz& quiz);
+  void updateQuestions(const Quiz& quiz);
 
 public slots:
   void activate(const QModelIndex& index);
 
 private:
+  struct Row {
+    Question question{};
+    bool answered{false};
+    QVariant decoration{};
+    QVariant display{};
+    QVariant toolTip{};
+  };
+
+  bool isValidRow(const int row) const;
+  void markAnswered(const int row);
+  void setupRow(Row& row);
+
+  QVariant _alignment{};
+  QSet<QChar> _answered{};
+  QHash<int, QVariant> _badges{};
+  WQuestion *_dialog{nullptr};
+  DocumentCache *_docs{nullptr};
+  QVariant _font{};
   int _fontSize{};
-  QList<Question> _questions{};
+  bool _keepAnswered{false};
+  QVector<Row> _rows{};
 
 signals:
+  void answered(const QChar& c);
   void uncovered(const QChar& c);
 };
 
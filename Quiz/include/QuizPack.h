@@ -0,0 +1,80 @@
+/****************************************************************************
+** Copyright (c) 2023, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#pragma once
+
+#include <memory>
+
+#include <QtCore/QByteArray>
+#include <QtCore/QFile>
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QString>
+
+class QuizPack {
+public:
+  struct Entry {
+    QString name{};
+    QByteArray data{};
+    QString source{}; // File to read, if data is null
+  };
+
+  QuizPack(const QuizPack&) = delete;
+  QuizPack& operator=(const QuizPack&) = delete;
+
+  ~QuizPack();
+
+  bool contains(const QString& path) const;
+  QByteArray data(const QString& path) const;
+  QString fileName() const;
+  QString filePath(const QString& name) const;
+  qint64 fileTime() const;
+  qint64 size(const QString& path) const;
+
+  static std::shared_ptr<const QuizPack> open(const QString& filename, QString *errmsg = nullptr);
+  static bool write(const QString& filename, const QList<Entry>& entries, QString *errmsg = nullptr);
+
+private:
+  struct Blob {
+    qint64 offset{0};
+    qint64 size{0};
+  };
+
+  QuizPack() = default;
+
+  const Blob *find(const QString& path) const;
+
+  const uchar *_data{nullptr};
+  QFile _file{};
+  qint64 _fileTime{-1};
+  QHash<QString,Blob> _index{};
+  QString _prefix{}; // "<pack>/"
+};
@@ -0,0 +1,87 @@
+/****************************************************************************
+** Copyright (c) 2023, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#pragma once
+
+#include <atomic>
+
+#include <QtCore/QStringList>
+
+#define TRACE_CONCAT_IMPL(a, b)  a##b
+#define TRACE_CONCAT(a, b)       TRACE_CONCAT_IMPL(a, b)
+#define TRACE(name)              trace::Span TRACE_CONCAT(trace_span_, __LINE__){name}
+
+namespace trace {
+
+  namespace impl {
+
+    inline std::atomic<bool> enabled{false};
+
+    qint64 now();
+    void record(const char *name, const qint64 begin, const qint64 end);
+
+  } // namespace impl
+
+  inline bool isEnabled()
+  {
+    return impl::enabled.load(std::memory_order_relaxed);
+  }
+
+  void setup(QStringList& args);
+  void start(const QString& filename);
+  bool stop();
+
+  class Span {
+  public:
+    Span(const char *name) noexcept
+      : _name{isEnabled() ? name : nullptr}
+    {
+      if( _name != nullptr ) {
+        _begin = impl::now();
+      }
+    }
+
+    ~Span() noexcept
+    {
+      if( _name != nullptr && isEnabled() ) {
+        impl::record(_name, _begin, impl::now());
+      }
+    }
+
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+
+  private:
+    const char *_name{nullptr};
+    qint64 _begin{0};
+  };
+
+} // namespace trace
@@ -37,4 +37,7 @@ namespace util {
 
   QImage rotated(const QImage& image, const int angle);
 
+  QImage transformed(const QImage& image, const int angle,
+                     const bool flipH, const bool flipV);
+
 } // namespace util
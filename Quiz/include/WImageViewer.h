@@ -31,29 +31,58 @@
 
 #pragma once
 
+#include <QtCore/QHash>
 #include <QtWidgets/QWidget>
 
 #include "Image.h"
 
+class QTimer;
+
+class ImageLoader;
+
 class WImageViewer : public QWidget {
   Q_OBJECT
 public:
   WImageViewer(const Images& images, QWidget *parent = nullptr, Qt::WindowFlags f = Qt::WindowFlags());
   ~WImageViewer();
 
+  static QSize displaySize();
+
+  void setSmoothDelay(const int msecs);
+
 protected:
+  void closeEvent(QCloseEvent *event);
   void keyPressEvent(QKeyEvent *event);
   void paintEvent(QPaintEvent *event);
+  void resizeEvent(QResizeEvent *event);
+
+private slots:
+  void imageLoaded(int id, const QImage& image);
 
 private:
+  int index() const;
   bool isBegin() const;
   bool isEmpty() const;
+  void loadImages();
+  void scaleImage(const Qt::TransformationMode mode);
+  void setImage(const QImage& image);
+  void storeFrame(const int id, const QImage& image);
   void updateImage();
 
   using positer_t = Images::const_iterator;
 
   QColor _bgColor{Qt::black};
+  QHash<int, QImage> _frames{};
   QImage _image{};
   Images _images{};
+  ImageLoader *_loader{nullptr};
   positer_t _pos{};
+  int _prefetchAhead{2};
+  int _prefetchBehind{1};
+  qint64 _prefetchBytes{256 * 1024 * 1024};
+  QImage _scaled{};
+  qreal _scaledDpr{0};
+  QSize _scaledSize{};
+  bool _scaledSmooth{false};
+  QTimer *_smoothTimer{nullptr};
 };
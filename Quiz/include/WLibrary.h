@@ -0,0 +1,79 @@
+/****************************************************************************
+** Copyright (c) 2023, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#pragma once
+
+#include <QtCore/QFutureWatcher>
+#include <QtWidgets/QDialog>
+
+#include "Library.h"
+
+namespace Ui {
+  class WLibrary;
+} // namespace Ui
+
+class QSortFilterProxyModel;
+
+class LibraryModel;
+
+class WLibrary : public QDialog {
+  Q_OBJECT
+public:
+  WLibrary(QWidget *parent = nullptr, Qt::WindowFlags f = Qt::WindowFlags());
+  ~WLibrary();
+
+  QString rootPath() const;
+  void setRootPath(const QString& path);
+
+signals:
+  void quizSelected(const QString& filename);
+
+private slots:
+  void chooseFolder();
+  void openCurrent();
+  void rescan();
+  void scanFinished();
+
+private:
+  struct Scan {
+    LibraryEntries entries{};
+    int parsed{0};
+    QString rootPath{};
+  };
+
+  void showStatus(const QString& what);
+
+  Ui::WLibrary *ui{nullptr};
+  LibraryModel *_model{nullptr};
+  QSortFilterProxyModel *_proxy{nullptr};
+  QString _rootPath{};
+  QFutureWatcher<Scan> *_watcher{nullptr};
+};
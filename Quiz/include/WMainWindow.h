@@ -32,15 +32,24 @@
 #ifndef WMAINWINDOW_H
 #define WMAINWINDOW_H
 
+#include <QtCore/QSet>
 #include <QtWidgets/QMainWindow>
 
 #include "data.h"
+#include "Journal.h"
 
 namespace Ui {
   class WMainWindow;
 } // namespace Ui
 
+class QFileSystemWatcher;
+class QTimer;
+
+class DocumentCache;
+class ImageWarmup;
 class QuestionsModel;
+class WLibrary;
+class WQuestion;
 
 class WMainWindow : public QMainWindow {
   Q_OBJECT
@@ -50,14 +59,35 @@ public:
 
 public slots:
   void open();
+  void openFile(const QString& filename);
+  void openLibrary();
   void uncover(const QChar& c);
 
+private slots:
+  void fileChanged(const QString& path);
+  void reload();
+
 private:
+  bool isFinished() const;
+  void replay(const QList<Journal::Entry>& entries);
+  void restartJournal();
   void setupQuiz(const Quiz& quiz);
+  void setupSolution();
+  void watchFiles();
 
   Ui::WMainWindow *ui{nullptr};
+  QSet<QString> _changedImages{};
+  DocumentCache *_documentCache{nullptr};
+  QFileSystemWatcher *_fileWatcher{nullptr};
+  QString _filename{};
+  Journal _journal{};
+  ImageWarmup *_imageWarmup{nullptr};
+  WQuestion *_questionDialog{nullptr};
+  WLibrary *_library{nullptr};
   QuestionsModel *_questionsModel{nullptr};
   Quiz _quiz{};
+  bool _quizChanged{false};
+  QTimer *_reloadTimer{nullptr};
 };
 
 #endif // WMAINWINDOW_H
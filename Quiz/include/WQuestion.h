@@ -39,13 +39,22 @@ namespace Ui {
   class WQuestion;
 } // namespace Ui
 
+class QTextDocument;
+
+class DocumentCache;
+
 class WQuestion : public QDialog {
   Q_OBJECT
 public:
   WQuestion(QWidget *parent = nullptr, Qt::WindowFlags f = Qt::WindowFlags());
   ~WQuestion();
 
-  void setQuestion(const int fontSize, const Question& q);
+  void done(int r);
+  void setQuestion(const Question& q, DocumentCache *docs);
+  int textWidth();
+
+protected:
+  void showEvent(QShowEvent *event);
 
 private slots:
   void showAnswer();
@@ -54,6 +63,7 @@ private:
   void enableOk(const bool enable);
 
   Ui::WQuestion *ui;
-  int _fontSize{};
-  Question _question{};
+  QTextDocument *_blank{nullptr};
+  DocumentCache *_docs{nullptr};
+  const Question *_question{nullptr};
 };
@@ -0,0 +1,417 @@
+/****************************************************************************
+** Copyright (c) 2023, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#include <algorithm>
+#include <cstdio>
+
+#include <QtConcurrent/QtConcurrentMap>
+#include <QtCore/QAtomicInt>
+#include <QtCore/QBuffer>
+#include <QtCore/QDir>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QSet>
+#include <QtCore/QTextStream>
+#include <QtCore/QThreadPool>
+#include <QtGui/QGuiApplication>
+#include <QtGui/QImageReader>
+#include <QtGui/QScreen>
+
+#include "Commands.h"
+
+#include "Corpus.h"
+#include "Data.h"
+#include "ImageCache.h"
+#include "QuizPack.h"
+
+////// Private ///////////////////////////////////////////////////////////////
+
+namespace impl {
+
+  QString batchName(const QString& solution, QSet<QString>& used)
+  {
+    QString base;
+    for( const QChar& c : solution.toLower() ) {
+      if( c.isLetterOrNumber() ) {
+        base += c;
+      } else if( !base.isEmpty() && !base.endsWith(QChar::fromLatin1('_')) ) {
+        base += QChar::fromLatin1('_');
+      }
+    }
+    while( base.endsWith(QChar::fromLatin1('_')) ) {
+      base.chop(1);
+    }
+    if( base.isEmpty() ) {
+      base = QStringLiteral("quiz");
+    }
+
+    QString name = base;
+    for( int no = 2; used.contains(name); no++ ) {
+      name = QStringLiteral("%1-%2").arg(base).arg(no);
+    }
+    used.insert(name);
+
+    return name + QStringLiteral(".xml");
+  }
+
+} // namespace impl
+
+////// public ////////////////////////////////////////////////////////////////
+
+namespace commands {
+
+  bool benchmark(const QString& filename, const int iterations)
+  {
+    if( iterations < 1 ) {
+      std::fprintf(stderr, "Invalid number of iterations!\n");
+      return false;
+    }
+
+    const auto print = [iterations](const char *what, const qint64 nsecs) -> void {
+      std::printf("%-8s %12.3f ms\n", what, double(nsecs) / double(iterations) / 1000000.0);
+    };
+
+    QElapsedTimer timer;
+
+    // (1) Read ////////////////////////////////////////////////////////////////
+
+    QString errmsg;
+    Quiz quiz;
+    timer.start();
+    for( int i = 0; i < iterations; i++ ) {
+      quiz = Quiz::load(filename, &errmsg);
+    }
+    const qint64 read_ns = timer.nsecsElapsed();
+
+    if( quiz.isEmpty() ) {
+      std::fprintf(stderr, "%s\n", qPrintable(errmsg));
+      return false;
+    }
+
+    // (2) Solve ///////////////////////////////////////////////////////////////
+
+    const QString letters = quiz.letters;
+    timer.restart();
+    for( int i = 0; i < iterations; i++ ) {
+      quiz.reset();
+      for( const QChar& c : letters ) {
+        quiz.solve(c);
+      }
+    }
+    const qint64 solve_ns = timer.nsecsElapsed();
+
+    // (3) Images; decoding only, i.e. without the cache ///////////////////////
+
+    const QScreen *screen = QGuiApplication::primaryScreen();
+    const QSize size      = screen != nullptr
+                            ? screen->size() * screen->devicePixelRatio()
+                            : QSize();
+
+    int images = 0;
+    timer.restart();
+    for( int i = 0; i < iterations; i++ ) {
+      ImageCache::instance().clear();
+      images = 0;
+      for( const Question& question : quiz.questions ) {
+        for( const Image& image : question.images ) {
+          image.load(size);
+          images++;
+        }
+      }
+    }
+    const qint64 images_ns = timer.nsecsElapsed();
+
+    std::printf("%s: %d questions, %d images, %d iterations\n", qPrintable(filename),
+                int(quiz.questions.size()), images, iterations);
+    print("read", read_ns);
+    print("solve", solve_ns);
+    print("images", images_ns);
+
+    return true;
+  }
+
+  bool compile(const QString& input, const QString& output)
+  {
+    QString errmsg;
+    const Quiz q = Quiz::read(input, &errmsg);
+    if( q.isEmpty() ) {
+      std::fprintf(stderr, "%s\n", qPrintable(errmsg));
+      return false;
+    }
+    return q.writeCompiled(output, input);
+  }
+
+  bool generate(const QString& solution, const QString& output)
+  {
+    const Quiz q(solution);
+    if( q.isEmpty() || !q.write(output) ) {
+      std::fprintf(stderr, "%s: Unable to write quiz!\n", qPrintable(output));
+      return false;
+    }
+    return true;
+  }
+
+  bool generateBatch(const QString& wordList, const QString& outputDir)
+  {
+    struct Job {
+      QString filename{};
+      QString solution{};
+    };
+
+    // (1) Jobs; one per line of input /////////////////////////////////////////
+
+    QFile file;
+    bool is_open = false;
+    if( wordList == QStringLiteral("-") ) {
+      is_open = file.open(stdin, QIODevice::ReadOnly | QIODevice::Text);
+    } else {
+      file.setFileName(wordList);
+      is_open = file.open(QIODevice::ReadOnly | QIODevice::Text);
+    }
+    if( !is_open ) {
+      std::fprintf(stderr, "%s: %s\n", qPrintable(wordList), qPrintable(file.errorString()));
+      return false;
+    }
+
+    const QDir dir(outputDir);
+    if( !dir.mkpath(QStringLiteral(".")) ) {
+      std::fprintf(stderr, "%s: Unable to create directory!\n", qPrintable(outputDir));
+      return false;
+    }
+
+    QList<Job> jobs;
+    QSet<QString> used;
+    QTextStream stream(&file);
+    stream.setCodec("UTF-8");
+    for( QString line; stream.readLineInto(&line); ) {
+      line = line.trimmed();
+      if( !line.isEmpty() ) {
+        jobs.push_back(Job{dir.filePath(impl::batchName(line, used)), line});
+      }
+    }
+
+    // (2) Generate on all cores ///////////////////////////////////////////////
+
+    QAtomicInt failed{0};
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QtConcurrent::blockingMap(jobs, [&failed](const Job& job) -> void {
+      const Quiz q(job.solution);
+      if( q.isEmpty() || !q.write(job.filename) ) {
+        failed.ref();
+      }
+    });
+
+    const qint64 msecs = std::max<qint64>(1, timer.elapsed());
+
+    // (3) Statistics //////////////////////////////////////////////////////////
+
+    const int count = jobs.size() - failed.loadAcquire();
+    std::printf("Generated %d of %d quizzes in %.3f s (%.1f quizzes/s, %d threads)\n",
+                count, int(jobs.size()), double(msecs) / 1000.0,
+                double(count) * 1000.0 / double(msecs),
+                QThreadPool::globalInstance()->maxThreadCount());
+
+    return failed.loadAcquire() == 0;
+  }
+
+  bool generateCorpus(const QString& outputDir, const QStringList& options)
+  {
+    Corpus corpus;
+    for( const QString& option : options ) {
+      const int at        = option.indexOf(QChar::fromLatin1('='));
+      const QString key   = option.left(at);
+      const QString value = option.mid(at + 1);
+
+      bool ok = true;
+      if(        at <= 0 ) {
+        ok = false;
+      } else if( key == QStringLiteral("format") ) {
+        corpus.imageFormat = value.toLatin1().toLower();
+      } else if( key == QStringLiteral("images") ) {
+        corpus.images = value.toInt(&ok);
+      } else if( key == QStringLiteral("questions") ) {
+        corpus.questions = value.toInt(&ok);
+      } else if( key == QStringLiteral("quizzes") ) {
+        corpus.quizzes = value.toInt(&ok);
+      } else if( key == QStringLiteral("seed") ) {
+        corpus.seed = value.toUInt(&ok);
+      } else if( key == QStringLiteral("size") ) {
+        const QStringList wh = value.split(QChar::fromLatin1('x'));
+        bool okH = false;
+        corpus.imageSize = wh.size() == 2
+                           ? QSize(wh[0].toInt(&ok), wh[1].toInt(&okH))
+                           : QSize();
+        ok = ok && okH;
+      } else if( key == QStringLiteral("transform") ) {
+        ok = value == QStringLiteral("on") || value == QStringLiteral("off");
+        corpus.transform = value == QStringLiteral("on");
+      } else if( key == QStringLiteral("words") ) {
+        corpus.words = value.toInt(&ok);
+      } else {
+        ok = false;
+      }
+
+      if( !ok ) {
+        std::fprintf(stderr, "Invalid option \"%s\"!\n", qPrintable(option));
+        return false;
+      }
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QString errmsg;
+    if( !corpus.write(outputDir, &errmsg) ) {
+      std::fprintf(stderr, "%s\n", qPrintable(errmsg));
+      return false;
+    }
+
+    std::printf("Generated %d quizzes with %d questions and %d images each in %.3f s (seed %u)\n",
+                corpus.quizzes, corpus.questions, corpus.questions * corpus.images,
+                double(timer.elapsed()) / 1000.0, corpus.seed);
+
+    return true;
+  }
+
+  bool pack(const QString& input, const QString& output)
+  {
+    QString errmsg;
+    const Quiz q = Quiz::load(input, &errmsg);
+    if( q.isEmpty() || !q.writePack(output, &errmsg) ) {
+      std::fprintf(stderr, "%s\n", qPrintable(errmsg));
+      return false;
+    }
+    return true;
+  }
+
+  bool validate(const QStringList& filenames)
+  {
+    int failed = 0;
+    for( const QString& filename : filenames ) {
+      QString errmsg;
+      const Quiz q = Quiz::load(filename, &errmsg);
+      if( q.isEmpty() ) {
+        std::fprintf(stderr, "%s\n", qPrintable(errmsg));
+        failed++;
+        continue;
+      }
+
+      int broken = 0;
+      int images = 0;
+      for( const Question& question : q.questions ) {
+        for( const Image& image : question.images ) {
+          images++;
+
+          QBuffer buffer;
+          QImageReader reader;
+          if( image.pack ) {
+            buffer.setData(image.pack->data(image.path));
+            buffer.open(QIODevice::ReadOnly);
+            reader.setDevice(&buffer);
+          } else {
+            reader.setFileName(image.path);
+          }
+          if( !reader.canRead() ) {
+            std::fprintf(stderr, "%s: %s: %s\n", qPrintable(filename),
+                         qPrintable(image.path), qPrintable(reader.errorString()));
+            broken++;
+          }
+        }
+      }
+
+      std::printf("%s: %d questions, %d images, %d broken\n", qPrintable(filename),
+                  int(q.questions.size()), images, broken);
+
+      if( broken > 0 ) {
+        failed++;
+      }
+    } // For Each File
+
+    return failed == 0;
+  }
+
+  bool isCommand(const QString& name)
+  {
+    static const QStringList NAMES = {
+      QStringLiteral("benchmark"), QStringLiteral("compile"), QStringLiteral("generate"),
+      QStringLiteral("generate-batch"), QStringLiteral("generate-corpus"), QStringLiteral("pack"),
+      QStringLiteral("validate")
+    };
+    return NAMES.contains(name);
+  }
+
+  bool needsGui(const QString& name)
+  {
+    return name == QStringLiteral("benchmark") || name == QStringLiteral("generate-corpus");
+  }
+
+  bool run(const QStringList& args)
+  {
+    bool ok = false;
+    if(        args.size() >= 2 && args.size() <= 3 && args[0] == QStringLiteral("benchmark") ) {
+      ok = benchmark(args[1], args.value(2, QStringLiteral("10")).toInt());
+    } else if( args.size() == 3 && args[0] == QStringLiteral("compile") ) {
+      ok = compile(args[1], args[2]);
+    } else if( args.size() >= 2 && args.size() <= 3 && args[0] == QStringLiteral("generate") ) {
+      ok = generate(args[1], args.value(2, QStringLiteral("output.xml")));
+    } else if( args.size() == 3 && args[0] == QStringLiteral("generate-batch") ) {
+      ok = generateBatch(args[1], args[2]);
+    } else if( args.size() >= 2 && args[0] == QStringLiteral("generate-corpus") ) {
+      ok = generateCorpus(args[1], args.mid(2));
+    } else if( args.size() == 3 && args[0] == QStringLiteral("pack") ) {
+      ok = pack(args[1], args[2]);
+    } else if( args.size() >= 2 && args[0] == QStringLiteral("validate") ) {
+      ok = validate(args.mid(1));
+    } else {
+      usage();
+    }
+    return ok;
+  }
+
+  void usage()
+  {
+    std::fprintf(stderr,
+                 "Usage: quizctl [-trace <file>] <command> [arguments]\n"
+                 "\n"
+                 "Commands:\n"
+                 "  benchmark <quiz> [iterations]\n"
+                 "  compile <quiz.xml> <quiz.qzb>\n"
+                 "  generate <solution> [output.xml]\n"
+                 "  generate-batch <list|-> <outdir>\n"
+                 "  generate-corpus <outdir> [option=value ...]\n"
+                 "  pack <quiz> <quiz.quizpack>\n"
+                 "  validate <quiz> ...\n");
+  }
+
+} // namespace commands
@@ -0,0 +1,381 @@
+/****************************************************************************
+** Copyright (c) 2023, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#include <algorithm>
+#include <type_traits>
+
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDateTime>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QSaveFile>
+
+#include "Data.h"
+
+#include "Trace.h"
+
+////// Private ///////////////////////////////////////////////////////////////
+
+namespace priv {
+
+  namespace qzb {
+
+    /*
+     * NOTE: A compiled quiz is laid out as follows (native byte order):
+     *
+     * Header
+     * Question[Header::numQuestions]
+     * Image[Header::numImages]
+     * char16_t[Header::numChars]      // String table; UTF-16, pre-trimmed
+     */
+
+    constexpr quint32 MAGIC   = 0x00425A51; // "QZB\0"; detects byte order, too
+    constexpr quint32 VERSION = 2;
+
+    constexpr int HASH_SIZE = 20;
+
+    struct String {
+      quint32 offset{0}; // in char16_t
+      quint32 length{0}; // in char16_t
+    };
+
+    struct Header {
+      quint32 magic{MAGIC};
+      quint32 version{VERSION};
+      qint64 sourceTime{0}; // msecs since epoch
+      quint8 sourceHash[HASH_SIZE]{};
+      String source{};
+      qint32 fontSize{DEFAULT_FONTSIZE};
+      String solution{};
+      String letters{};
+      quint32 numQuestions{0};
+      quint32 numImages{0};
+      quint32 numChars{0};
+      quint32 reserved{0};
+    };
+
+    struct Question {
+      String answer{};
+      String category{};
+      String question{};
+      quint32 letter{0};
+      quint32 firstImage{0};
+      quint32 numImages{0};
+    };
+
+    struct Image {
+      String bgColor{};
+      String path{};       // Absolute; resolved when compiled
+      qint64 fileSize{-1};
+      qint64 fileTime{-1}; // msecs since epoch
+      qint32 rotate{0};
+      quint8 flipH{0};
+      quint8 flipV{0};
+      quint8 reserved[2]{};
+    };
+
+    static_assert(std::is_trivially_copyable_v<Header> && sizeof(Header) == 80);
+    static_assert(std::is_trivially_copyable_v<Question> && sizeof(Question) == 36);
+    static_assert(std::is_trivially_copyable_v<Image> && sizeof(Image) == 40);
+
+    class StringTable {
+    public:
+      StringTable() = default;
+
+      String add(const QString& s)
+      {
+        String result;
+        result.offset = quint32(_chars.size());
+        result.length = quint32(s.size());
+        _chars.append(s);
+        return result;
+      }
+
+      const QString& chars() const
+      {
+        return _chars;
+      }
+
+    private:
+      QString _chars{};
+    };
+
+    template<typename T>
+    void append(QByteArray& data, const T& value)
+    {
+      data.append(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+  } // namespace qzb
+
+  QByteArray sourceHash(const QString& filename)
+  {
+    QFile file(filename);
+    if( !file.open(QIODevice::ReadOnly) ) {
+      return QByteArray();
+    }
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    if( !hash.addData(&file) ) {
+      return QByteArray();
+    }
+
+    return hash.result();
+  }
+
+  qint64 sourceTime(const QString& filename)
+  {
+    return QFileInfo(filename).lastModified().toMSecsSinceEpoch();
+  }
+
+  bool isStale(const qzb::Header& header, const QString& source)
+  {
+    if( source.isEmpty() || !QFileInfo::exists(source) ) {
+      return false; // Nothing to fall back to...
+    }
+
+    const qint64 time = sourceTime(source);
+    if( time == header.sourceTime ) {
+      return false;
+    }
+
+    const QByteArray hash = QByteArray::fromRawData(reinterpret_cast<const char *>(header.sourceHash), qzb::HASH_SIZE);
+    return sourceHash(source) != hash;
+  }
+
+  bool isLetterTable(const QString& letters)
+  {
+    constexpr auto if_not_ascending = [](const QChar& a, const QChar& b) -> bool {
+      return !(a < b);
+    };
+
+    return !letters.isEmpty()
+           && std::adjacent_find(letters.cbegin(), letters.cend(), if_not_ascending) == letters.cend();
+  }
+
+  void setError(QString *errmsg, const QString& filename, const QString& what)
+  {
+    if( errmsg != nullptr ) {
+      *errmsg = QStringLiteral("%1: %2").arg(filename, what);
+    }
+  }
+
+} // namespace priv
+
+////// public ////////////////////////////////////////////////////////////////
+
+bool Quiz::writeCompiled(const QString& filename, const QString& source) const
+{
+  if( isEmpty() ) {
+    return false;
+  }
+
+  const QByteArray hash = priv::sourceHash(source);
+  if( hash.size() != priv::qzb::HASH_SIZE ) {
+    return false;
+  }
+
+  priv::qzb::StringTable strings;
+
+  // (1) Header //////////////////////////////////////////////////////////////
+
+  priv::qzb::Header header;
+  header.sourceTime = priv::sourceTime(source);
+  std::copy(hash.cbegin(), hash.cend(), header.sourceHash);
+  header.source       = strings.add(QFileInfo(source).absoluteFilePath());
+  header.fontSize     = fontSize;
+  header.solution     = strings.add(solution);
+  header.letters      = strings.add(letters);
+  header.numQuestions = quint32(questions.size());
+
+  // (2) Questions & Images //////////////////////////////////////////////////
+
+  QByteArray data_questions;
+  QByteArray data_images;
+  for( const Question& q : questions ) {
+    priv::qzb::Question rec;
+    rec.answer     = strings.add(q.answer);
+    rec.category   = strings.add(q.category);
+    rec.question   = strings.add(q.question);
+    rec.letter     = q.letter.unicode();
+    rec.firstImage = header.numImages;
+    rec.numImages  = quint32(q.images.size());
+    priv::qzb::append(data_questions, rec);
+
+    for( const Image& i : q.images ) {
+      priv::qzb::Image img;
+      img.bgColor = strings.add(i.bgColor);
+      img.path     = strings.add(QFileInfo(i.path).absoluteFilePath());
+      img.fileSize = i.fileSize;
+      img.fileTime = i.fileTime;
+      img.rotate   = i.rotate;
+      img.flipH    = i.flipH ? 1 : 0;
+      img.flipV    = i.flipV ? 1 : 0;
+      priv::qzb::append(data_images, img);
+    }
+    header.numImages += rec.numImages;
+  }
+
+  header.numChars = quint32(strings.chars().size());
+
+  // (3) Output //////////////////////////////////////////////////////////////
+
+  QSaveFile file(filename);
+  if( !file.open(QIODevice::WriteOnly) ) {
+    return false;
+  }
+
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  file.write(data_questions);
+  file.write(data_images);
+  file.write(reinterpret_cast<const char *>(strings.chars().utf16()),
+             qint64(strings.chars().size()) * qint64(sizeof(char16_t)));
+
+  return file.commit();
+}
+
+Quiz Quiz::readCompiled(const QString& filename, QString *errmsg)
+{
+  TRACE("Quiz::readCompiled");
+
+  using namespace priv;
+
+  if( errmsg != nullptr ) {
+    errmsg->clear();
+  }
+
+  QFile file(filename);
+  if( !file.open(QIODevice::ReadOnly) ) {
+    setError(errmsg, filename, file.errorString());
+    return Quiz();
+  }
+
+  const qint64 size = file.size();
+  const uchar *data = size >= qint64(sizeof(qzb::Header))
+                      ? file.map(0, size)
+                      : nullptr;
+  if( data == nullptr ) {
+    setError(errmsg, filename, QStringLiteral("Unable to map compiled quiz!"));
+    return Quiz();
+  }
+
+  // (1) Sections ////////////////////////////////////////////////////////////
+
+  const qzb::Header *header = reinterpret_cast<const qzb::Header *>(data);
+  if( header->magic != qzb::MAGIC || header->version != qzb::VERSION ) {
+    setError(errmsg, filename, QStringLiteral("Invalid or outdated compiled quiz!"));
+    return Quiz();
+  }
+
+  const quint64 required = quint64(sizeof(qzb::Header))
+                           + quint64(header->numQuestions) * sizeof(qzb::Question)
+                           + quint64(header->numImages) * sizeof(qzb::Image)
+                           + quint64(header->numChars) * sizeof(char16_t);
+  if( quint64(size) < required ) {
+    setError(errmsg, filename, QStringLiteral("Truncated compiled quiz!"));
+    return Quiz();
+  }
+
+  const auto *rec_questions = reinterpret_cast<const qzb::Question *>(header + 1);
+  const auto *rec_images    = reinterpret_cast<const qzb::Image *>(rec_questions + header->numQuestions);
+  const auto *chars         = reinterpret_cast<const QChar *>(rec_images + header->numImages);
+
+  bool ok               = true;
+  const auto toString = [&](const qzb::String& s) -> QString {
+    if( quint64(s.offset) + quint64(s.length) > header->numChars ) {
+      ok = false;
+      return QString();
+    }
+    return QString(chars + s.offset, int(s.length));
+  };
+
+  // (2) Fall back to the source when stale //////////////////////////////////
+
+  const QString source = toString(header->source);
+  if( ok && isStale(*header, source) ) {
+    return Quiz::read(source, errmsg);
+  }
+
+  // (3) Quiz ////////////////////////////////////////////////////////////////
+
+  Quiz result;
+  result.fontSize = header->fontSize;
+  result.letters  = toString(header->letters);
+  result.solution = toString(header->solution);
+  if( !isLetterTable(result.letters) ) {
+    ok = false;
+  }
+
+  result.questions.reserve(int(header->numQuestions));
+  for( quint32 i = 0; i < header->numQuestions && ok; i++ ) {
+    const qzb::Question& rec = rec_questions[i];
+    if( quint64(rec.firstImage) + quint64(rec.numImages) > header->numImages ) {
+      ok = false;
+      break;
+    }
+
+    Question q;
+    q.answer   = toString(rec.answer);
+    q.category = toString(rec.category);
+    q.letter   = QChar(ushort(rec.letter));
+    q.question = toString(rec.question);
+
+    for( quint32 j = rec.firstImage; j < rec.firstImage + rec.numImages; j++ ) {
+      const qzb::Image& img = rec_images[j];
+
+      Image image;
+      image.bgColor  = toString(img.bgColor);
+      image.fileSize = img.fileSize;
+      image.fileTime = img.fileTime;
+      image.flipH    = img.flipH != 0;
+      image.flipV    = img.flipV != 0;
+      image.path     = toString(img.path);
+      image.rotate   = img.rotate;
+      q.images.push_back(image);
+    }
+
+    result.questions.push_back(q);
+  }
+
+  if( !ok ) {
+    setError(errmsg, filename, QStringLiteral("Corrupt compiled quiz!"));
+    return Quiz();
+  }
+
+  result.indexLetters();
+  result.reset();
+  if( result.isEmpty() ) {
+    setError(errmsg, filename, QStringLiteral("Empty quiz!"));
+    return Quiz();
+  }
+
+  return result;
+}
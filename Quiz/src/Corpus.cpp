@@ -0,0 +1,291 @@
+/****************************************************************************
+** Copyright (c) 2023, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#include <algorithm>
+#include <utility>
+
+#include <QtConcurrent/QtConcurrentMap>
+#include <QtCore/QAtomicInt>
+#include <QtCore/QDir>
+#include <QtCore/QRandomGenerator>
+#include <QtGui/QImage>
+#include <QtGui/QImageWriter>
+#include <QtGui/QPainter>
+
+#include "Corpus.h"
+
+#include "Data.h"
+
+////// Private ///////////////////////////////////////////////////////////////
+
+namespace impl {
+
+  struct ImageJob {
+    QString filename{};
+    QSize size{};
+    quint32 seed{};
+  };
+
+  QString letterPool(const int count)
+  {
+    constexpr std::pair<ushort,ushort> RANGES[] = {
+      {0x0041, 0x005A}, {0x0391, 0x03A9}, {0x0410, 0x042F}, {0x4E00, 0x9FFF}
+    };
+
+    QString pool;
+    for( const auto& range : RANGES ) {
+      for( uint u = range.first; u <= range.second && pool.size() < count; u++ ) {
+        const QChar c(ushort(u));
+        if( c.isLetter() && c.toUpper() == c ) {
+          pool += c;
+        }
+      }
+    }
+
+    return pool;
+  }
+
+  QString makeSolution(QRandomGenerator& rng, QString letters)
+  {
+    for( int i = letters.size() - 1; i > 0; i-- ) {
+      const int j   = int(rng.bounded(i + 1));
+      const QChar c = letters.at(i);
+      letters[i]    = letters.at(j);
+      letters[j]    = c;
+    }
+
+    QString solution;
+    int next = 0;
+    while( next < letters.size() ) {
+      if( !solution.isEmpty() ) {
+        solution += QChar::fromLatin1(' ');
+      }
+
+      const int len = 3 + int(rng.bounded(6));
+      for( int k = 0; k < len; k++ ) {
+        if( next < letters.size() && (next == 0 || rng.bounded(4) != 0) ) {
+          solution += letters.at(next++);
+        } else {
+          solution += letters.at(int(rng.bounded(next)));
+        }
+      }
+    }
+
+    return solution;
+  }
+
+  QString makeHtml(QRandomGenerator& rng, const QString& title, const int words)
+  {
+    static const char *const VOCABULARY[] = {
+      "alpha", "bravo", "charlie", "delta", "echo", "foxtrot", "golf",
+      "hotel", "india", "juliett", "kilo", "lima", "mike", "november",
+      "oscar", "papa", "quebec", "romeo", "sierra", "tango", "uniform",
+      "victor", "whiskey", "xray", "yankee", "zulu"
+    };
+    constexpr int COUNT = int(sizeof(VOCABULARY) / sizeof(VOCABULARY[0]));
+
+    QString html = QStringLiteral("<h3>%1</h3><p>").arg(title);
+    for( int i = 0; i < words; i++ ) {
+      if( i > 0 && i % 60 == 0 ) {
+        html += QStringLiteral("</p><p>");
+      }
+
+      const QString word = QString::fromLatin1(VOCABULARY[rng.bounded(COUNT)]);
+      const int style    = int(rng.bounded(16));
+      if(        style == 0 ) {
+        html += QStringLiteral("<b>%1</b> ").arg(word);
+      } else if( style == 1 ) {
+        html += QStringLiteral("<i>%1</i> ").arg(word);
+      } else {
+        html += word + QChar::fromLatin1(' ');
+      }
+    }
+    html += QStringLiteral("</p>");
+
+    return html;
+  }
+
+  QImage makeImage(const QSize& size, const quint32 seed)
+  {
+    QRandomGenerator rng(seed);
+
+    const auto color = [&rng]() -> QColor {
+      return QColor::fromHsv(int(rng.bounded(360)), 128 + int(rng.bounded(128)), 128 + int(rng.bounded(128)));
+    };
+
+    QImage image(size, QImage::Format_RGB32);
+
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::Antialiasing, true);
+
+    QLinearGradient gradient(0, 0, size.width(), size.height());
+    gradient.setColorAt(0, color());
+    gradient.setColorAt(1, color());
+    painter.fillRect(image.rect(), gradient);
+
+    const int d = std::max<int>(2, std::min<int>(size.width(), size.height()) / 6);
+    painter.setPen(Qt::NoPen);
+    for( int i = 0; i < 64; i++ ) {
+      painter.setBrush(color());
+      const QRect r(int(rng.bounded(size.width())), int(rng.bounded(size.height())),
+                    1 + int(rng.bounded(d)), 1 + int(rng.bounded(d)));
+      if( i % 2 == 0 ) {
+        painter.drawEllipse(r);
+      } else {
+        painter.drawRect(r);
+      }
+    }
+
+    painter.setBrush(Qt::white);
+    painter.drawRect(0, 0, std::max<int>(1, size.width() / 10), std::max<int>(1, size.height() / 20));
+
+    return image;
+  }
+
+  Quiz makeQuiz(QRandomGenerator& rng, const Corpus& corpus, const QString& pool,
+                const int no, const QDir *dir, QList<ImageJob> *jobs)
+  {
+    Quiz quiz(makeSolution(rng, pool));
+
+    int qno = 0;
+    for( Question& q : quiz.questions ) {
+      qno++;
+
+      q.answer   = makeHtml(rng, QStringLiteral("Answer %1").arg(qno), corpus.words);
+      q.category = QStringLiteral("Category %1").arg(1 + rng.bounded(12));
+      q.question = makeHtml(rng, QStringLiteral("Question %1").arg(qno), corpus.words);
+
+      for( int ino = 1; dir != nullptr && ino <= corpus.images; ino++ ) {
+        Image image;
+        if( corpus.transform ) {
+          image.flipH  = rng.bounded(4) == 0;
+          image.flipV  = rng.bounded(4) == 0;
+          image.rotate = 90 * int(rng.bounded(4));
+        }
+        image.path = dir->absoluteFilePath(QStringLiteral("images/%1-%2-%3.%4")
+                                           .arg(no, 3, 10, QChar::fromLatin1('0'))
+                                           .arg(qno, 5, 10, QChar::fromLatin1('0'))
+                                           .arg(ino)
+                                           .arg(QString::fromLatin1(corpus.imageFormat)));
+        q.images.push_back(image);
+
+        const bool is_transposed = image.rotate == 90 || image.rotate == 270;
+        jobs->push_back(ImageJob{image.path,
+                                 is_transposed ? corpus.imageSize.transposed() : corpus.imageSize,
+                                 rng.generate()});
+      } // For Each Image
+    } // For Each Question
+
+    return quiz;
+  }
+
+  bool setError(QString *errmsg, const QString& what)
+  {
+    if( errmsg != nullptr ) {
+      *errmsg = what;
+    }
+    return false;
+  }
+
+} // namespace impl
+
+////// public ////////////////////////////////////////////////////////////////
+
+QImage Corpus::makeImage(const QSize& size, const quint32 seed)
+{
+  return impl::makeImage(size, seed);
+}
+
+int Corpus::maxQuestions()
+{
+  return impl::letterPool(0x10000).size();
+}
+
+Quiz Corpus::makeQuiz() const
+{
+  if( questions < 1 || questions > maxQuestions() ) {
+    return Quiz();
+  }
+
+  QRandomGenerator rng(seed);
+  return impl::makeQuiz(rng, *this, impl::letterPool(questions), 1, nullptr, nullptr);
+}
+
+bool Corpus::write(const QString& outputDir, QString *errmsg) const
+{
+  if( questions < 1 || questions > maxQuestions() ) {
+    return impl::setError(errmsg, QStringLiteral("Invalid number of questions (1-%1)!").arg(maxQuestions()));
+  }
+  if( images < 0 || quizzes < 1 || words < 0 ) {
+    return impl::setError(errmsg, QStringLiteral("Invalid number of images, quizzes or words!"));
+  }
+  if( images > 0
+      && (imageSize.isEmpty() || !QImageWriter::supportedImageFormats().contains(imageFormat)) ) {
+    return impl::setError(errmsg, QStringLiteral("Invalid image size or format!"));
+  }
+
+  const QDir dir(outputDir);
+  if( !dir.mkpath(QStringLiteral("images")) ) {
+    return impl::setError(errmsg, QStringLiteral("%1: Unable to create directory!").arg(outputDir));
+  }
+
+  QRandomGenerator rng(seed);
+  const QString pool = impl::letterPool(questions);
+
+  // (1) Quizzes; images are rendered afterwards /////////////////////////////
+
+  QList<impl::ImageJob> jobs;
+  for( int no = 1; no <= quizzes; no++ ) {
+    const Quiz quiz = impl::makeQuiz(rng, *this, pool, no, &dir, &jobs);
+
+    const QString filename = dir.filePath(QStringLiteral("quiz-%1.xml")
+                                          .arg(no, 3, 10, QChar::fromLatin1('0')));
+    if( !quiz.write(filename) ) {
+      return impl::setError(errmsg, QStringLiteral("%1: Unable to write quiz!").arg(filename));
+    }
+  } // For Each Quiz
+
+  // (2) Images; on all cores ////////////////////////////////////////////////
+
+  QAtomicInt failed{0};
+  QtConcurrent::blockingMap(jobs, [this, &failed](const impl::ImageJob& job) -> void {
+    if( !impl::makeImage(job.size, job.seed).save(job.filename, imageFormat.constData()) ) {
+      failed.ref();
+    }
+  });
+
+  if( failed.loadAcquire() != 0 ) {
+    return impl::setError(errmsg, QStringLiteral("Unable to write %1 of %2 images!")
+                          .arg(failed.loadAcquire()).arg(jobs.size()));
+  }
+
+  return true;
+}
@@ -35,81 +35,86 @@
 #include <QtCore/QDir>
 #include <QtCore/QFile>
 #include <QtCore/QFileInfo>
-#include <QtCore/QTextStream>
-#include <QtXml/QDomDocument>
+#include <QtCore/QSaveFile>
+#include <QtCore/QXmlStreamReader>
+#include <QtCore/QXmlStreamWriter>
 
 #include "data.h"
 
+#include "PathResolver.h"
+
+#include "Trace.h"
+
 ////// Private ///////////////////////////////////////////////////////////////
 
 namespace priv {
 
-  QString adjustImagePath(const QString& imagePath, const QString& basePath)
+  void writeImage(QXmlStreamWriter& xml, const Image& image, const QString& name)
   {
-    if( QFileInfo::exists(imagePath) ) {
-      return imagePath;
-    }
+    xml.writeStartElement(QStringLiteral("image"));
 
-    const QDir dir       = QFileInfo(basePath).absoluteDir();
-    const QFileInfo info = QFileInfo(dir, imagePath);
-    if( info.exists() ) {
-      return info.absoluteFilePath();
+    if( !image.bgColor.isEmpty() ) {
+      xml.writeAttribute(QStringLiteral("bg"), image.bgColor);
+    }
+    if( image.flipH ) {
+      xml.writeAttribute(QStringLiteral("flip_h"), QStringLiteral("true"));
+    }
+    if( image.flipV ) {
+      xml.writeAttribute(QStringLiteral("flip_v"), QStringLiteral("true"));
+    }
+    if( image.rotate != 0 ) {
+      xml.writeAttribute(QStringLiteral("rotate"), QString::number(image.rotate));
     }
 
-    return QString();
-  }
-
-  void appendText(QDomDocument& doc, QDomNode& parent,
-                  const QString& tag, const QString& text)
-  {
-    QDomElement xml_elem = doc.createElement(tag);
-    parent.appendChild(xml_elem);
+    xml.writeCharacters(name);
 
-    QDomText xml_text = doc.createTextNode(text);
-    xml_elem.appendChild(xml_text);
+    xml.writeEndElement();
   }
 
-  bool probeBoolAttribute(const QDomElement& elem,
+  bool probeBoolAttribute(const QXmlStreamAttributes& attrs,
                           const QString& attr, const bool defValue = false)
   {
-    if( elem.isNull() ) {
+    if( !attrs.hasAttribute(attr) ) {
       return defValue;
     }
 
-    const QString defValueStr = defValue
-                                ? QStringLiteral("true")
-                                : QStringLiteral("false");
-
-    return elem.attribute(attr, defValueStr) == QStringLiteral("true");
+    return attrs.value(attr) == QLatin1String("true");
   }
 
-  int probeIntAttribute(const QDomElement& elem,
+  int probeIntAttribute(const QXmlStreamAttributes& attrs,
                         const QString& attr, const int defValue = 0, const int base = 10)
   {
-    if( elem.isNull() ) {
+    if( !attrs.hasAttribute(attr) ) {
       return defValue;
     }
 
-    const QString defValueStr = QString::number(defValue, base);
-
     bool ok             = false;
-    const int attrValue = elem.attribute(attr, defValueStr).toInt(&ok, base);
+    const int attrValue = attrs.value(attr).toInt(&ok, base);
     return ok
            ? attrValue
            : defValue;
   }
 
-  QString readText(const QDomNode& parent, const QString& tag)
+  QString readText(QXmlStreamReader& xml)
   {
-    const QDomElement xml_child = parent.firstChildElement(tag);
-    return xml_child.isNull()
-           ? QString()
-           : xml_child.text();
+    QString text;
+    for( int depth = 1; depth > 0 && !xml.atEnd(); ) {
+      const QXmlStreamReader::TokenType token = xml.readNext();
+      if(        token == QXmlStreamReader::StartElement ) {
+        depth++;
+      } else if( token == QXmlStreamReader::EndElement ) {
+        depth--;
+      } else if( token == QXmlStreamReader::Characters ) {
+        if( xml.isCDATA() || !xml.isWhitespace() ) {
+          text += xml.text();
+        }
+      }
+    }
+    return text;
   }
 
-  void assignText(QString& lhs, const QDomNode& parent, const QString& tag)
+  void assignText(QString& lhs, const QString& text)
   {
-    const QString text = readText(parent, tag);
     if( !text.isEmpty() ) {
       constexpr QChar LF = QChar::fromLatin1('\n');
       if( text.contains(LF) ) {
@@ -124,6 +129,69 @@ namespace priv {
     }
   }
 
+  void setError(QString *errmsg, const QString& filename,
+                const QXmlStreamReader& xml, const QString& what)
+  {
+    if( errmsg == nullptr ) {
+      return;
+    }
+
+    *errmsg = QStringLiteral("%1:%2:%3: %4 (offset %5)")
+                .arg(filename)
+                .arg(xml.lineNumber())
+                .arg(xml.columnNumber())
+                .arg(what)
+                .arg(xml.characterOffset());
+  }
+
+  Image readImage(QXmlStreamReader& xml, const ImageResolveFunc& resolve)
+  {
+    const QXmlStreamAttributes attrs = xml.attributes();
+
+    Image image;
+
+    image.bgColor = attrs.value(QStringLiteral("bg")).toString();
+    image.flipH   = probeBoolAttribute(attrs, QStringLiteral("flip_h"));
+    image.flipV   = probeBoolAttribute(attrs, QStringLiteral("flip_v"));
+    image.rotate  = probeIntAttribute(attrs, QStringLiteral("rotate"));
+
+    if( !resolve(image, readText(xml)) ) {
+      image.path.clear();
+    }
+
+    return image;
+  }
+
+  Question readQuestion(QXmlStreamReader& xml, const ImageResolveFunc& resolve)
+  {
+    Question result;
+
+    bool have_answer   = false;
+    bool have_category = false;
+    bool have_question = false;
+    while( xml.readNextStartElement() ) {
+      if(        xml.name() == QLatin1String("answer") && !have_answer ) {
+        result.answer = readText(xml);
+        have_answer   = true;
+      } else if( xml.name() == QLatin1String("category") && !have_category ) {
+        result.category = readText(xml);
+        have_category   = true;
+      } else if( xml.name() == QLatin1String("question") && !have_question ) {
+        result.question = readText(xml);
+        have_question   = true;
+      } else if( xml.name() == QLatin1String("image") ) {
+        const Image image = readImage(xml, resolve);
+        if( !image.path.isEmpty() ) {
+          result.images.push_back(image);
+        }
+      } else {
+        xml.skipCurrentElement();
+      }
+    }
+
+    return result;
+  }
+
 } // namespace priv
 
 ////// public ////////////////////////////////////////////////////////////////
@@ -137,11 +205,14 @@ Quiz::Quiz(const QString& _solution)
   }
 
   for( const QChar& c : solution ) {
-    if( c.isLetter() && !letters.contains(c) ) {
+    if( c.isLetter() ) {
       letters.push_back(c);
     }
   }
   std::sort(letters.begin(), letters.end());
+  letters.truncate(int(std::distance(letters.begin(), std::unique(letters.begin(), letters.end()))));
+
+  indexLetters();
 
   for( int i = 0; i < letters.size(); i++ ) {
     const int no = i + 1;
@@ -156,6 +227,21 @@ Quiz::Quiz(const QString& _solution)
   reset();
 }
 
+void Quiz::indexLetters()
+{
+  letterPositions.clear();
+  for( int i = 0; i < letters.size(); i++ ) {
+    letterPositions.push_back(QVector<int>());
+  }
+
+  for( int i = 0; i < solution.size(); i++ ) {
+    const auto hit = std::lower_bound(letters.cbegin(), letters.cend(), solution[i]);
+    if( hit != letters.cend() && *hit == solution[i] ) {
+      letterPositions[int(std::distance(letters.cbegin(), hit))].push_back(i);
+    }
+  }
+}
+
 bool Quiz::isEmpty() const
 {
   return letters.isEmpty() || questions.isEmpty() || solution.isEmpty();
@@ -173,101 +259,184 @@ void Quiz::reset()
   std::replace_if(displayText.begin(), displayText.end(), if_letter, UNDERSCORE);
 }
 
-QString Quiz::solve(const QChar& c)
+QString Quiz::solve(const QChar& c, QVector<int> *changed)
 {
+  if( changed != nullptr ) {
+    changed->clear();
+  }
+
   if( !c.isLetter() ) {
     return displayText;
   }
 
+  const QChar C = c.toUpper();
+
+  const auto hit = std::lower_bound(letters.cbegin(), letters.cend(), C);
+  if( hit == letters.cend() || *hit != C ) {
+    return displayText;
+  }
+
   const int len = std::min<int>(displayText.size(), solution.size());
-  for( int i = 0; i < len; i++ ) {
-    if( solution[i] == c.toUpper() ) {
+  for( const int i : letterPositions.at(int(std::distance(letters.cbegin(), hit))) ) {
+    if( i < len && displayText[i] != solution[i] ) {
       displayText[i] = solution[i];
+      if( changed != nullptr ) {
+        changed->push_back(i);
+      }
     }
   }
 
   return displayText;
 }
 
-void Quiz::write(const QString& filename) const
+bool Quiz::write(const QString& filename) const
+{
+  QSaveFile file(filename);
+  if( !file.open(QIODevice::WriteOnly) ) {
+    return false;
+  }
+
+  const QDir dir = QFileInfo(filename).absoluteDir();
+  const auto relative = [&dir](const Image& image) -> QString {
+    return dir.relativeFilePath(QFileInfo(image.path).absoluteFilePath());
+  };
+
+  if( !write(&file, relative) ) {
+    file.cancelWriting();
+    return false;
+  }
+
+  return file.commit();
+}
+
+bool Quiz::write(QIODevice *device, const ImageNameFunc& imageName) const
 {
-  QDomDocument doc;
+  QXmlStreamWriter xml(device);
+  xml.setAutoFormatting(true);
+  xml.setAutoFormattingIndent(1);
 
-  QDomElement xml_root = doc.createElement(QStringLiteral("quiz"));
-  doc.appendChild(xml_root);
+  xml.writeStartDocument();
+  xml.writeStartElement(QStringLiteral("quiz"));
+  xml.writeAttribute(QStringLiteral("font_size"), QString::number(fontSize));
 
-  priv::appendText(doc, xml_root, QStringLiteral("solution"), solution);
+  xml.writeTextElement(QStringLiteral("solution"), solution);
 
   for( const Question& q : questions ) {
-    QDomElement xml_question = doc.createElement(QStringLiteral("question"));
-    xml_root.appendChild(xml_question);
+    xml.writeStartElement(QStringLiteral("question"));
 
-    priv::appendText(doc, xml_question, QStringLiteral("answer"), q.answer);
-    priv::appendText(doc, xml_question, QStringLiteral("category"), q.category);
-    priv::appendText(doc, xml_question, QStringLiteral("question"), q.question);
-  }
+    xml.writeTextElement(QStringLiteral("answer"), q.answer);
+    xml.writeTextElement(QStringLiteral("category"), q.category);
+    xml.writeTextElement(QStringLiteral("question"), q.question);
 
-  QFile file(filename);
-  if( !file.open(QIODevice::WriteOnly) ) {
-    return;
-  }
+    for( const Image& image : q.images ) {
+      priv::writeImage(xml, image, imageName(image));
+    }
+
+    xml.writeEndElement();
+  } // For Each Question
+
+  xml.writeEndElement();
+  xml.writeEndDocument();
 
-  QTextStream stream(&file);
-  stream << doc.toString();
-  stream.flush();
+  return !xml.hasError();
 }
 
-Quiz Quiz::read(const QString& filename)
+Quiz Quiz::load(const QString& filename, QString *errmsg)
 {
-  Quiz result;
+  if(        filename.endsWith(QStringLiteral(".qzb"), Qt::CaseInsensitive) ) {
+    return readCompiled(filename, errmsg);
+  } else if( filename.endsWith(QStringLiteral(".quizpack"), Qt::CaseInsensitive) ) {
+    return readPack(filename, errmsg);
+  }
+  return read(filename, errmsg);
+}
+
+Quiz Quiz::read(const QString& filename, QString *errmsg)
+{
+  TRACE("Quiz::read");
+
+  if( errmsg != nullptr ) {
+    errmsg->clear();
+  }
 
   QFile file(filename);
   if( !file.open(QIODevice::ReadOnly) ) {
+    if( errmsg != nullptr ) {
+      *errmsg = QStringLiteral("%1: %2").arg(filename, file.errorString());
+    }
     return Quiz();
   }
 
-  QDomDocument doc;
-  if( !doc.setContent(&file) ) {
+  PathResolver resolver(filename);
+  const auto resolve = [&resolver](Image& image, const QString& imagePath) -> bool {
+    return resolver.resolve(image, imagePath);
+  };
+
+  return read(&file, filename, resolve, errmsg);
+}
+
+Quiz Quiz::read(QIODevice *device, const QString& filename,
+                const ImageResolveFunc& resolve, QString *errmsg)
+{
+  if( errmsg != nullptr ) {
+    errmsg->clear();
+  }
+
+  QXmlStreamReader xml(device);
+
+  if( !xml.readNextStartElement() || xml.name() != QLatin1String("quiz") ) {
+    priv::setError(errmsg, filename, xml, xml.hasError()
+                                          ? xml.errorString()
+                                          : QStringLiteral("Missing <quiz> element!"));
     return Quiz();
   }
 
-  const QDomElement xml_quiz = doc.firstChildElement(QStringLiteral("quiz"));
-  if( xml_quiz.isNull() ) {
+  const int fontSize = priv::probeIntAttribute(xml.attributes(), QStringLiteral("font_size"), DEFAULT_FONTSIZE);
+
+  QString solution;
+  bool have_solution = false;
+  QList<Question> questions;
+  while( xml.readNextStartElement() ) {
+    if(        xml.name() == QLatin1String("solution") && !have_solution ) {
+      solution      = priv::readText(xml);
+      have_solution = true;
+    } else if( xml.name() == QLatin1String("question") ) {
+      questions.push_back(priv::readQuestion(xml, resolve));
+    } else {
+      xml.skipCurrentElement();
+    }
+  }
+
+  // (1) Parse the remainder to reject malformed documents as a whole ////////
+
+  while( !xml.atEnd() ) {
+    xml.readNext();
+  }
+
+  if( xml.hasError() ) {
+    priv::setError(errmsg, filename, xml, xml.errorString());
     return Quiz();
   }
 
-  result = Quiz(priv::readText(xml_quiz, QStringLiteral("solution")));
+  // (2) Setup quiz //////////////////////////////////////////////////////////
+
+  Quiz result(solution);
   if( result.isEmpty() ) {
+    priv::setError(errmsg, filename, xml, QStringLiteral("Empty <solution>!"));
     return Quiz();
   }
 
-  result.fontSize = priv::probeIntAttribute(xml_quiz, QStringLiteral("font_size"), DEFAULT_FONTSIZE);
-
-  auto it = result.questions.begin();
-  for( QDomElement xml_question = xml_quiz.firstChildElement(QStringLiteral("question"));
-       !xml_question.isNull() && it != result.questions.end();
-       xml_question = xml_question.nextSiblingElement(QStringLiteral("question")), ++it ) {
-    priv::assignText(it->answer, xml_question, QStringLiteral("answer"));
-    priv::assignText(it->category, xml_question, QStringLiteral("category"));
-    priv::assignText(it->question, xml_question, QStringLiteral("question"));
-
-    it->images.clear();
-    for( QDomElement xml_image = xml_question.firstChildElement(QStringLiteral("image"));
-         !xml_image.isNull();
-         xml_image = xml_image.nextSiblingElement(QStringLiteral("image")) ) {
-      Image image;
-
-      image.path    = priv::adjustImagePath(xml_image.text(), filename);
-      image.bgColor = xml_image.attribute(QStringLiteral("bg"));
-      image.flipH   = priv::probeBoolAttribute(xml_image, QStringLiteral("flip_h"));
-      image.flipV   = priv::probeBoolAttribute(xml_image, QStringLiteral("flip_v"));
-      image.rotate  = priv::probeIntAttribute(xml_image, QStringLiteral("rotate"));
-
-      if( image.exists() ) {
-        it->images.push_back(image);
-      }
-    } // For Each Image
+  result.fontSize = fontSize;
+
+  auto src = questions.cbegin();
+  for( auto it = result.questions.begin();
+       it != result.questions.end() && src != questions.cend();
+       ++it, ++src ) {
+    priv::assignText(it->answer, src->answer);
+    priv::assignText(it->category, src->category);
+    priv::assignText(it->question, src->question);
 
+    it->images = src->images;
   } // For Each Question
 
   return result;
@@ -0,0 +1,219 @@
+/****************************************************************************
+** Copyright (c) 2023, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#include <QtCore/QSet>
+#include <QtCore/QTimer>
+#include <QtGui/QFont>
+#include <QtGui/QTextDocument>
+#include <QtGui/QTextOption>
+
+#include "DocumentCache.h"
+
+////// Private ///////////////////////////////////////////////////////////////
+
+namespace impl {
+
+  void setupDocument(QTextDocument *doc, const bool font_bold, const int font_size)
+  {
+    doc->clear();
+
+    // (1) Font //////////////////////////////////////////////////////////////
+
+    QFont font = doc->defaultFont();
+    font.setBold(font_bold);
+    if( font_size > 0 ) {
+      font.setPointSize(font_size);
+    }
+    doc->setDefaultFont(font);
+
+    // (2) Layout ////////////////////////////////////////////////////////////
+
+    QTextOption opt = doc->defaultTextOption();
+    opt.setAlignment(Qt::AlignCenter);
+    doc->setDefaultTextOption(opt);
+  }
+
+} // namespace impl
+
+////// public ////////////////////////////////////////////////////////////////
+
+DocumentCache::DocumentCache(QObject *parent)
+  : QObject(parent)
+{
+  _timer = new QTimer(this);
+  _timer->setInterval(0);
+
+  connect(_timer, &QTimer::timeout, this, &DocumentCache::prepareNext);
+}
+
+DocumentCache::~DocumentCache()
+{
+}
+
+QTextDocument *DocumentCache::answer(const Question& q)
+{
+  Entry& e = entry(q);
+  return document(e.answer, e.answerHtml);
+}
+
+QTextDocument *DocumentCache::question(const Question& q)
+{
+  Entry& e = entry(q);
+  return document(e.question, e.questionHtml);
+}
+
+void DocumentCache::setQuiz(const Quiz& quiz)
+{
+  clear();
+
+  _fontSize = quiz.fontSize;
+  for( const Question& q : quiz.questions ) {
+    entry(q);
+    _queue.push_back(q.letter);
+  }
+
+  _timer->start();
+}
+
+void DocumentCache::setTextWidth(const qreal width)
+{
+  if( width == _textWidth ) {
+    return;
+  }
+  _textWidth = width;
+
+  _queue = _entries.keys();
+  _timer->start();
+}
+
+void DocumentCache::updateQuiz(const Quiz& quiz)
+{
+  if( quiz.fontSize != _fontSize ) {
+    setQuiz(quiz);
+    return;
+  }
+
+  QSet<QChar> letters;
+  for( const Question& q : quiz.questions ) {
+    letters.insert(q.letter);
+
+    const Entry& e = entry(q);
+    if( (e.question == nullptr || e.answer == nullptr) && !_queue.contains(q.letter) ) {
+      _queue.push_back(q.letter);
+    }
+  }
+
+  for( auto it = _entries.begin(); it != _entries.end(); ) {
+    if( !letters.contains(it.key()) ) {
+      delete it->answer;
+      delete it->question;
+      it = _entries.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  _timer->start();
+}
+
+////// private slots /////////////////////////////////////////////////////////
+
+void DocumentCache::prepareNext()
+{
+  if( _queue.isEmpty() ) {
+    _timer->stop();
+    return;
+  }
+
+  const auto it = _entries.find(_queue.takeFirst());
+  if( it == _entries.end() ) {
+    return;
+  }
+
+  for( QTextDocument **doc : {&it->question, &it->answer} ) {
+    if( *doc != nullptr ) {
+      layout(*doc);
+    }
+  }
+  document(it->question, it->questionHtml);
+  document(it->answer, it->answerHtml);
+}
+
+////// private ///////////////////////////////////////////////////////////////
+
+void DocumentCache::clear()
+{
+  _timer->stop();
+  _queue.clear();
+
+  for( const Entry& e : qAsConst(_entries) ) {
+    delete e.answer;
+    delete e.question;
+  }
+  _entries.clear();
+}
+
+QTextDocument *DocumentCache::document(QTextDocument *& doc, const QString& html)
+{
+  if( doc == nullptr ) {
+    doc = new QTextDocument(this);
+    impl::setupDocument(doc, true, _fontSize);
+    doc->setHtml(html);
+    layout(doc);
+  }
+  return doc;
+}
+
+DocumentCache::Entry& DocumentCache::entry(const Question& q)
+{
+  Entry& e = _entries[q.letter];
+
+  if( e.questionHtml != q.question ) {
+    delete e.question;
+    e.question     = nullptr;
+    e.questionHtml = q.question;
+  }
+  if( e.answerHtml != q.answer ) {
+    delete e.answer;
+    e.answer     = nullptr;
+    e.answerHtml = q.answer;
+  }
+
+  return e;
+}
+
+void DocumentCache::layout(QTextDocument *doc) const
+{
+  if( _textWidth > 0 ) {
+    doc->setTextWidth(_textWidth);
+  }
+  doc->size(); // Forces a complete layout
+}
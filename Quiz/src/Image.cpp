@@ -29,19 +29,94 @@
 ** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 *****************************************************************************/
 
+#include <QtCore/QBuffer>
+#include <QtCore/QDateTime>
+#include <QtCore/QFile>
 #include <QtCore/QFileInfo>
 
 #include <QtGui/QImage>
+#include <QtGui/QImageReader>
 
 #include "Image.h"
 
+#include "ImageCache.h"
+
+#include "QuizPack.h"
+
+#include "Trace.h"
+
 #include "Util.h"
 
+////// Private ///////////////////////////////////////////////////////////////
+
+namespace impl {
+
+  QImage decode(const QByteArray& data, const QByteArray& format,
+                const int rotate, const QSize& targetSize)
+  {
+    TRACE("Image::decode");
+
+    QBuffer buffer;
+    buffer.setData(data);
+    if( !buffer.open(QIODevice::ReadOnly) ) {
+      return QImage();
+    }
+
+    QImageReader reader(&buffer, format);
+    reader.setAutoTransform(true);
+
+    const QSize size = reader.size();
+    if( targetSize.isValid() && size.isValid() ) {
+      bool is_transposed = reader.transformation().testFlag(QImageIOHandler::TransformationRotate90);
+      if( rotate == 90 || rotate == 270 ) {
+        is_transposed = !is_transposed;
+      }
+
+      const QSize bounds = is_transposed
+                           ? targetSize.transposed()
+                           : targetSize;
+      if( size.width() > bounds.width() || size.height() > bounds.height() ) {
+        reader.setScaledSize(size.scaled(bounds, Qt::KeepAspectRatio));
+      }
+    }
+
+    return reader.read();
+  }
+
+} // namespace impl
+
+////// public ////////////////////////////////////////////////////////////////
+
 Image::Image() noexcept = default;
 
+bool Image::canLoad() const
+{
+  TRACE("Image::canLoad");
+
+  QByteArray data;
+  if( pack ) {
+    data = pack->data(path);
+  } else {
+    QFile file(path);
+    if( file.open(QIODevice::ReadOnly) ) {
+      data = file.readAll();
+    }
+  }
+  if( data.isEmpty() ) {
+    return false;
+  }
+
+  const QSize thumbnail(64, 64);
+  return !impl::decode(data, QByteArray(), rotate, thumbnail).isNull()
+         || !impl::decode(data, QFileInfo(path).suffix().toLatin1(), rotate, thumbnail).isNull();
+}
+
 bool Image::exists() const
 {
-  return QFileInfo::exists(path);
+  if( pack ) {
+    return pack->contains(path);
+  }
+  return fileTime >= 0 || QFileInfo::exists(path);
 }
 
 QString Image::fileName() const
@@ -49,18 +124,87 @@ QString Image::fileName() const
   return QFileInfo(path).fileName();
 }
 
-QImage Image::load() const
+QImage Image::load(const QSize& targetSize) const
 {
-  QImage result;
-  if( !exists() || !result.load(path) ) {
-    return QImage{};
+  TRACE("Image::load");
+
+  qint64 mtime = fileTime;
+  if(        mtime < 0 && pack ) {
+    mtime = pack->fileTime();
+  } else if( mtime < 0 ) {
+    const QFileInfo info(path);
+    if( !info.exists() ) {
+      return QImage{};
+    }
+    mtime = info.lastModified().toMSecsSinceEpoch();
+  }
+
+  ImageCache& cache = ImageCache::instance();
+
+  const ImageCache::Key key{path, mtime, rotate, flipH, flipV, targetSize};
+
+  QImage result = cache.decoded(key);
+  if( !result.isNull() ) {
+    return result;
   }
 
-  if( rotate != 0 ) {
-    result = util::rotated(result, rotate);
-  } else if( flipH || flipV ) {
-    result = result.mirrored(flipH, flipV);
+  // (1) Encoded data ////////////////////////////////////////////////////////
+
+  // A pack's data refers to its mapping and must not enter the cache.
+  QByteArray data;
+  if( pack ) {
+    data = pack->data(path);
+    if( data.isEmpty() ) {
+      return QImage{};
+    }
+  } else {
+    data = cache.encoded(key.path, key.mtime);
+  }
+  if( data.isEmpty() ) {
+    QFile file(path);
+    if( !file.open(QIODevice::ReadOnly) ) {
+      return QImage{};
+    }
+    data = file.readAll();
+    cache.insertEncoded(key.path, key.mtime, data);
+  }
+
+  // (2) Decode; fall back to the suffix for formats without magic ///////////
+
+  result = impl::decode(data, QByteArray(), rotate, targetSize);
+  if( result.isNull() ) {
+    result = impl::decode(data, QFileInfo(path).suffix().toLatin1(), rotate, targetSize);
+  }
+  if( result.isNull() ) {
+    return QImage{};
   }
 
+  result = util::transformed(result, rotate, flipH, flipV);
+
+  cache.insertDecoded(key, result);
+
   return result;
 }
+
+bool Image::refresh()
+{
+  if( pack ) {
+    fileSize = pack->size(path);
+    fileTime = fileSize >= 0
+               ? pack->fileTime()
+               : -1;
+    return fileSize >= 0;
+  }
+
+  const QFileInfo info(path);
+  if( path.isEmpty() || !info.exists() ) {
+    fileSize = -1;
+    fileTime = -1;
+    return false;
+  }
+
+  fileSize = info.size();
+  fileTime = info.lastModified().toMSecsSinceEpoch();
+
+  return true;
+}
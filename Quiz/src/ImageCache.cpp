@@ -0,0 +1,310 @@
+/****************************************************************************
+** Copyright (c) 2023, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#include <list>
+#include <utility>
+
+#include "ImageCache.h"
+
+////// Private ///////////////////////////////////////////////////////////////
+
+namespace impl {
+
+  inline qint64 cost(const QByteArray& data)
+  {
+    return data.size();
+  }
+
+  inline qint64 cost(const QImage& image)
+  {
+    return image.sizeInBytes();
+  }
+
+  template<typename KeyT, typename ValueT>
+  class LruCache {
+  public:
+    LruCache(const qint64 budget)
+      : _budget{budget}
+    {
+    }
+
+    void clear()
+    {
+      _bytes = 0;
+      _entries.clear();
+      _index.clear();
+    }
+
+    bool find(const KeyT& key, ValueT& value)
+    {
+      const auto hit = _index.find(key);
+      if( hit == _index.end() ) {
+        _misses++;
+        return false;
+      }
+      _hits++;
+
+      // Move to front, i.e. most recently used...
+      _entries.splice(_entries.begin(), _entries, hit.value());
+      value = _entries.front().second;
+      return true;
+    }
+
+    void insert(const KeyT& key, const ValueT& value)
+    {
+      remove(key);
+
+      const qint64 bytes = cost(value);
+      if( bytes > _budget ) {
+        return;
+      }
+
+      _entries.emplace_front(key, value);
+      _index.insert(key, _entries.begin());
+      _bytes += bytes;
+
+      shrink();
+    }
+
+    void setBudget(const qint64 budget)
+    {
+      _budget = budget;
+      shrink();
+    }
+
+    qint64 budget() const
+    {
+      return _budget;
+    }
+
+    qint64 bytes() const
+    {
+      return _bytes;
+    }
+
+    quint64 evictions() const
+    {
+      return _evictions;
+    }
+
+    quint64 hits() const
+    {
+      return _hits;
+    }
+
+    quint64 misses() const
+    {
+      return _misses;
+    }
+
+    template<typename PredT>
+    void removeIf(PredT pred)
+    {
+      for( auto it = _entries.begin(); it != _entries.end(); ) {
+        if( pred(it->first) ) {
+          _bytes -= cost(it->second);
+          _index.remove(it->first);
+          it = _entries.erase(it);
+        } else {
+          ++it;
+        }
+      }
+    }
+
+  private:
+    using Entry = std::pair<KeyT, ValueT>;
+    using Entries = std::list<Entry>;
+
+    void remove(const KeyT& key)
+    {
+      const auto it = _index.find(key);
+      if( it == _index.end() ) {
+        return;
+      }
+      _bytes -= cost(it.value()->second);
+      _entries.erase(it.value());
+      _index.erase(it);
+    }
+
+    void shrink()
+    {
+      while( _bytes > _budget && !_entries.empty() ) {
+        const Entry& victim = _entries.back();
+        _bytes -= cost(victim.second);
+        _index.remove(victim.first);
+        _entries.pop_back();
+        _evictions++;
+      }
+    }
+
+    qint64 _budget{0};
+    qint64 _bytes{0};
+    Entries _entries{};
+    quint64 _evictions{0};
+    quint64 _hits{0};
+    QHash<KeyT, typename Entries::iterator> _index{};
+    quint64 _misses{0};
+  };
+
+  constexpr qint64 MiB = 1024 * 1024;
+
+} // namespace impl
+
+struct ImageCache::Tiers {
+  impl::LruCache<Key, QImage> decoded{256 * impl::MiB};
+  impl::LruCache<Key, QByteArray> encoded{64 * impl::MiB};
+};
+
+////// public ////////////////////////////////////////////////////////////////
+
+bool ImageCache::Key::operator==(const Key& other) const
+{
+  return path == other.path
+         && mtime == other.mtime
+         && rotate == other.rotate
+         && flipH == other.flipH
+         && flipV == other.flipV
+         && size == other.size;
+}
+
+ImageCache::~ImageCache()
+{
+}
+
+void ImageCache::clear()
+{
+  const QMutexLocker locker(&_mutex);
+  _tiers->decoded.clear();
+  _tiers->encoded.clear();
+}
+
+void ImageCache::evict(const QString& path)
+{
+  const auto is_path = [&path](const Key& key) -> bool {
+    return key.path == path;
+  };
+
+  const QMutexLocker locker(&_mutex);
+  _tiers->decoded.removeIf(is_path);
+  _tiers->encoded.removeIf(is_path);
+}
+
+ImageCache::Stats ImageCache::stats() const
+{
+  const QMutexLocker locker(&_mutex);
+
+  Stats result;
+
+  result.encodedBudget    = _tiers->encoded.budget();
+  result.encodedBytes     = _tiers->encoded.bytes();
+  result.encodedEvictions = _tiers->encoded.evictions();
+  result.encodedHits      = _tiers->encoded.hits();
+  result.encodedMisses    = _tiers->encoded.misses();
+
+  result.decodedBudget    = _tiers->decoded.budget();
+  result.decodedBytes     = _tiers->decoded.bytes();
+  result.decodedEvictions = _tiers->decoded.evictions();
+  result.decodedHits      = _tiers->decoded.hits();
+  result.decodedMisses    = _tiers->decoded.misses();
+
+  return result;
+}
+
+void ImageCache::setBudgets(const qint64 encodedBytes, const qint64 decodedBytes)
+{
+  const QMutexLocker locker(&_mutex);
+  _tiers->decoded.setBudget(decodedBytes);
+  _tiers->encoded.setBudget(encodedBytes);
+}
+
+QImage ImageCache::decoded(const Key& key)
+{
+  const QMutexLocker locker(&_mutex);
+
+  QImage result;
+  _tiers->decoded.find(key, result);
+  return result;
+}
+
+QByteArray ImageCache::encoded(const QString& path, const qint64 mtime)
+{
+  const QMutexLocker locker(&_mutex);
+
+  QByteArray result;
+  _tiers->encoded.find(Key{path, mtime}, result);
+  return result;
+}
+
+void ImageCache::insertDecoded(const Key& key, const QImage& image)
+{
+  if( image.isNull() ) {
+    return;
+  }
+
+  const QMutexLocker locker(&_mutex);
+  _tiers->decoded.insert(key, image);
+}
+
+void ImageCache::insertEncoded(const QString& path, const qint64 mtime, const QByteArray& data)
+{
+  if( data.isEmpty() ) {
+    return;
+  }
+
+  const QMutexLocker locker(&_mutex);
+  _tiers->encoded.insert(Key{path, mtime}, data);
+}
+
+ImageCache& ImageCache::instance()
+{
+  static ImageCache cache;
+  return cache;
+}
+
+////// private ///////////////////////////////////////////////////////////////
+
+ImageCache::ImageCache()
+  : _tiers{std::make_unique<Tiers>()}
+{
+}
+
+////// Global ////////////////////////////////////////////////////////////////
+
+uint qHash(const ImageCache::Key& key, uint seed)
+{
+  seed = qHash(key.path, seed);
+  seed = qHash(key.mtime, seed);
+  seed = qHash(key.rotate, seed);
+  seed = qHash((int(key.flipH) << 1) | int(key.flipV), seed);
+  seed = qHash(key.size.width(), seed);
+  seed = qHash(key.size.height(), seed);
+  return seed;
+}
@@ -0,0 +1,199 @@
+/****************************************************************************
+** Copyright (c) 2023, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#include <utility>
+
+#include <QtCore/QMutex>
+#include <QtCore/QRunnable>
+#include <QtCore/QWaitCondition>
+#include <QtGui/QImage>
+
+#include "ImageLoader.h"
+
+////// Private ///////////////////////////////////////////////////////////////
+
+namespace impl {
+
+  template<typename FuncT>
+  class Runnable : public QRunnable {
+  public:
+    Runnable(FuncT&& func)
+      : _func(std::move(func))
+    {
+    }
+
+    void run() final
+    {
+      _func();
+    }
+
+  private:
+    FuncT _func;
+  };
+
+  template<typename FuncT>
+  QRunnable *makeRunnable(FuncT&& func)
+  {
+    return new Runnable<FuncT>(std::move(func));
+  }
+
+  QMutex busyMutex;
+  QWaitCondition idle;
+  int busy{0};
+
+  void addBusy(const int count)
+  {
+    QMutexLocker locker(&busyMutex);
+    busy += count;
+    if( busy <= 0 ) {
+      idle.wakeAll();
+    }
+  }
+
+  constexpr quint64 makeWindow(const int first, const int last)
+  {
+    return (quint64(quint32(first)) << 32) | quint64(quint32(last));
+  }
+
+} // namespace impl
+
+////// public ////////////////////////////////////////////////////////////////
+
+ImageLoader::ImageLoader(QObject *parent)
+  : QObject(parent)
+{
+  _pool.setMaxThreadCount(2);
+
+  setWindow(0, -1);
+}
+
+ImageLoader::~ImageLoader()
+{
+  _pool.clear();
+  _pool.waitForDone();
+
+  impl::addBusy(-_pending.size());
+}
+
+bool ImageLoader::isPending(const int id) const
+{
+  return _pending.contains(id);
+}
+
+void ImageLoader::request(const int id, const Image& image, const int priority)
+{
+  if( isPending(id) ) {
+    return;
+  }
+
+  const Request req{image, priority};
+  _pending.insert(id, req);
+  impl::addBusy(1);
+  start(id, req);
+}
+
+void ImageLoader::setTargetSize(const QSize& size)
+{
+  _targetSize = size;
+}
+
+void ImageLoader::setWindow(const int first, const int last)
+{
+  _window.storeRelease(impl::makeWindow(first, last));
+}
+
+bool ImageLoader::isBusy()
+{
+  QMutexLocker locker(&impl::busyMutex);
+  return impl::busy > 0;
+}
+
+void ImageLoader::waitForIdle(const QAtomicInt& canceled)
+{
+  QMutexLocker locker(&impl::busyMutex);
+  while( impl::busy > 0 && canceled.loadAcquire() == 0 ) {
+    impl::idle.wait(&impl::busyMutex);
+  }
+}
+
+void ImageLoader::wakeWaiting()
+{
+  QMutexLocker locker(&impl::busyMutex);
+  impl::idle.wakeAll();
+}
+
+////// private ///////////////////////////////////////////////////////////////
+
+void ImageLoader::finish(const int id, const QImage& image, const bool skipped)
+{
+  const auto it = _pending.find(id);
+  if( it == _pending.end() ) {
+    return;
+  }
+
+  if( skipped ) {
+    if( isWanted(id) ) {
+      start(id, it.value());
+    } else {
+      _pending.erase(it);
+      impl::addBusy(-1);
+    }
+    return;
+  }
+
+  _pending.erase(it);
+  impl::addBusy(-1);
+
+  emit loaded(id, image);
+}
+
+bool ImageLoader::isWanted(const int id) const
+{
+  const quint64 window = _window.loadAcquire();
+  const int first      = int(quint32(window >> 32));
+  const int last       = int(quint32(window));
+  return first <= id && id <= last;
+}
+
+void ImageLoader::start(const int id, const Request& req)
+{
+  _pool.start(impl::makeRunnable([this, id, image = req.image, size = _targetSize]() -> void {
+    const bool skipped = !isWanted(id);
+
+    const QImage result = skipped
+                          ? QImage()
+                          : image.load(size);
+
+    QMetaObject::invokeMethod(this, [this, id, result, skipped]() -> void {
+      finish(id, result, skipped);
+    }, Qt::QueuedConnection);
+  }), req.priority);
+}
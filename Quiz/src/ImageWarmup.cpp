@@ -0,0 +1,155 @@
+/****************************************************************************
+** Copyright (c) 2023, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#include <QtCore/QRunnable>
+#include <QtCore/QThread>
+#include <QtGui/QImage>
+
+#include "ImageWarmup.h"
+
+#include "ImageCache.h"
+#include "ImageLoader.h"
+
+////// Private ///////////////////////////////////////////////////////////////
+
+namespace impl {
+
+  using Canceled = std::shared_ptr<QAtomicInt>;
+
+  class WarmupTask : public QRunnable {
+  public:
+    WarmupTask(ImageWarmup *warmup, const Canceled& canceled,
+               const Images& images, const QSize& targetSize)
+      : _canceled{canceled}
+      , _images{images}
+      , _targetSize{targetSize}
+      , _warmup{warmup}
+    {
+    }
+
+    void run() final
+    {
+      QThread::currentThread()->setPriority(QThread::LowestPriority);
+
+      const qint64 budget = ImageCache::instance().stats().decodedBudget / 2;
+      const qint64 frame  = _targetSize.isValid()
+                            ? qint64(_targetSize.width()) * qint64(_targetSize.height()) * 4
+                            : 0;
+
+      const int total = int(_images.size());
+
+      qint64 bytes = 0;
+      int cached   = 0;
+      int done     = 0;
+      int failed   = 0;
+      for( const Image& image : _images ) {
+        ImageLoader::waitForIdle(*_canceled);
+        if( isCanceled() ) {
+          break;
+        }
+
+        if( bytes + frame <= budget ) {
+          const QImage loaded = image.load(_targetSize);
+          if( loaded.isNull() ) {
+            failed++;
+          } else {
+            cached++;
+          }
+          bytes += loaded.sizeInBytes();
+        } else if( !image.canLoad() ) {
+          failed++;
+        }
+        done++;
+
+        if( !isCanceled() ) {
+          QMetaObject::invokeMethod(_warmup, "progress", Qt::QueuedConnection,
+                                    Q_ARG(int, done), Q_ARG(int, total));
+        }
+      }
+
+      if( !isCanceled() ) {
+        QMetaObject::invokeMethod(_warmup, "finished", Qt::QueuedConnection,
+                                  Q_ARG(int, done), Q_ARG(int, failed), Q_ARG(int, cached));
+      }
+
+      QThread::currentThread()->setPriority(QThread::NormalPriority);
+    }
+
+  private:
+    bool isCanceled() const
+    {
+      return _canceled->loadAcquire() != 0;
+    }
+
+    Canceled _canceled{};
+    Images _images{};
+    QSize _targetSize{};
+    ImageWarmup *_warmup{nullptr};
+  };
+
+} // namespace impl
+
+////// public ////////////////////////////////////////////////////////////////
+
+ImageWarmup::ImageWarmup(QObject *parent)
+  : QObject(parent)
+{
+  _pool.setMaxThreadCount(1);
+}
+
+ImageWarmup::~ImageWarmup()
+{
+  cancel();
+  _pool.waitForDone();
+}
+
+void ImageWarmup::cancel()
+{
+  _canceled->storeRelease(1);
+  _pool.clear();
+  ImageLoader::wakeWaiting();
+}
+
+void ImageWarmup::start(const Quiz& quiz, const QSize& targetSize)
+{
+  cancel();
+
+  Images images;
+  for( const Question& q : quiz.questions ) {
+    images.insert(images.end(), q.images.cbegin(), q.images.cend());
+  }
+  if( images.empty() ) {
+    return;
+  }
+
+  _canceled = std::make_shared<QAtomicInt>(0);
+  _pool.start(new impl::WarmupTask(this, _canceled, images, targetSize));
+}
@@ -0,0 +1,287 @@
+/****************************************************************************
+** Copyright (c) 2023, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#include <cstring>
+#include <type_traits>
+
+#if defined(Q_OS_WIN)
+# include <io.h>
+#else
+# include <unistd.h>
+#endif
+
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDateTime>
+
+#include "Journal.h"
+
+#include "Data.h"
+
+////// Private ///////////////////////////////////////////////////////////////
+
+namespace impl {
+
+  /*
+   * NOTE: A journal is laid out as follows (native byte order):
+   *
+   * Header
+   * Record[]   // Consecutive sequence numbers; a torn tail is ignored
+   */
+
+  constexpr quint32 MAGIC         = 0x4C4E4A51; // "QJNL"; detects byte order, too
+  constexpr quint32 RECORD_MAGIC  = 0x31524A51; // "QJR1"
+  constexpr quint32 VERSION       = 1;
+
+  constexpr int HASH_SIZE = 20;
+
+  struct Header {
+    quint32 magic{MAGIC};
+    quint32 version{VERSION};
+    quint32 recordSize{0};
+    quint32 reserved{0};
+    quint8 solutionHash[HASH_SIZE]{};
+    quint8 reserved2[12]{};
+  };
+
+  struct Record {
+    quint32 magic{RECORD_MAGIC};
+    quint16 action{0};
+    quint16 letter{0};
+    quint32 sequence{0};
+    quint32 checksum{0}; // FNV-1a of the record with checksum == 0
+    qint64 time{0};
+  };
+
+  static_assert(std::is_trivially_copyable_v<Header> && sizeof(Header) == 48);
+  static_assert(std::is_trivially_copyable_v<Record> && sizeof(Record) == 24);
+
+  quint32 checksum(Record r)
+  {
+    r.checksum = 0;
+
+    const uchar *data = reinterpret_cast<const uchar *>(&r);
+    quint32 hash = 2166136261u;
+    for( std::size_t i = 0; i < sizeof(Record); i++ ) {
+      hash ^= data[i];
+      hash *= 16777619u;
+    }
+    return hash;
+  }
+
+  QByteArray solutionHash(const Quiz& quiz)
+  {
+    return QCryptographicHash::hash(QByteArray(reinterpret_cast<const char *>(quiz.solution.utf16()),
+                                               quiz.solution.size() * int(sizeof(char16_t))),
+                                    QCryptographicHash::Sha1);
+  }
+
+  // Returns the number of valid records or -1 if the header doesn't match.
+  int countRecords(const QByteArray& data, const QByteArray& hash)
+  {
+    if( data.size() < int(sizeof(Header)) ) {
+      return -1;
+    }
+
+    Header header;
+    std::memcpy(&header, data.constData(), sizeof(Header));
+    if( header.magic != MAGIC
+        || header.version != VERSION
+        || header.recordSize != sizeof(Record)
+        || hash.size() != HASH_SIZE
+        || std::memcmp(header.solutionHash, hash.constData(), HASH_SIZE) != 0 ) {
+      return -1;
+    }
+
+    const int max = (data.size() - int(sizeof(Header))) / int(sizeof(Record));
+
+    int count = 0;
+    for( ; count < max; count++ ) {
+      Record r;
+      std::memcpy(&r, data.constData() + sizeof(Header) + std::size_t(count) * sizeof(Record), sizeof(Record));
+      if( r.magic != RECORD_MAGIC
+          || r.sequence != quint32(count)
+          || r.checksum != checksum(r)
+          || (r.action != Journal::Reveal && r.action != Journal::Answer) ) {
+        break;
+      }
+    }
+
+    return count;
+  }
+
+  bool sync(const int fd)
+  {
+#if defined(Q_OS_WIN)
+    return ::_commit(fd) == 0;
+#else
+    return ::fsync(fd) == 0;
+#endif
+  }
+
+} // namespace impl
+
+////// public ////////////////////////////////////////////////////////////////
+
+Journal::~Journal()
+{
+  close();
+}
+
+void Journal::close()
+{
+  if( _file.isOpen() ) {
+    _file.close();
+  }
+  _sequence = 0;
+}
+
+bool Journal::isOpen() const
+{
+  return _file.isOpen();
+}
+
+bool Journal::open(const QString& quizFile, const Quiz& quiz, const bool resume)
+{
+  close();
+
+  const QByteArray hash = impl::solutionHash(quiz);
+
+  _file.setFileName(fileName(quizFile));
+
+  int count = -1;
+  if( resume && _file.open(QIODevice::ReadOnly) ) {
+    count = impl::countRecords(_file.readAll(), hash);
+    _file.close();
+  }
+
+  // (1) Continue; drop any record torn by a crash ///////////////////////////
+
+  if( count >= 0 ) {
+    const qint64 size = qint64(sizeof(impl::Header)) + qint64(count) * qint64(sizeof(impl::Record));
+    if( !_file.open(QIODevice::ReadWrite | QIODevice::Unbuffered)
+        || !_file.resize(size)
+        || !_file.seek(size) ) {
+      close();
+      return false;
+    }
+
+    _sequence = quint32(count);
+
+    return true;
+  }
+
+  // (2) Start anew //////////////////////////////////////////////////////////
+
+  if( !_file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Unbuffered) ) {
+    return false;
+  }
+
+  impl::Header header;
+  header.recordSize = sizeof(impl::Record);
+  std::memcpy(header.solutionHash, hash.constData(), impl::HASH_SIZE);
+
+  if( _file.write(reinterpret_cast<const char *>(&header), sizeof(header)) != qint64(sizeof(header)) ) {
+    close();
+    return false;
+  }
+
+  if( _sync == SyncAlways ) {
+    impl::sync(_file.handle());
+  }
+
+  return true;
+}
+
+bool Journal::record(const Action action, const QChar& letter)
+{
+  if( !_file.isOpen() ) {
+    return false;
+  }
+
+  impl::Record r;
+  r.action   = action;
+  r.letter   = letter.unicode();
+  r.sequence = _sequence;
+  r.time     = QDateTime::currentMSecsSinceEpoch();
+  r.checksum = impl::checksum(r);
+
+  if( _file.write(reinterpret_cast<const char *>(&r), sizeof(r)) != qint64(sizeof(r)) ) {
+    return false;
+  }
+  _sequence++;
+
+  if( _sync == SyncAlways ) {
+    return impl::sync(_file.handle());
+  }
+
+  return true;
+}
+
+bool Journal::remove()
+{
+  close();
+  return _file.fileName().isEmpty() || !_file.exists() || _file.remove();
+}
+
+void Journal::setSync(const Sync sync)
+{
+  _sync = sync;
+}
+
+QString Journal::fileName(const QString& quizFile)
+{
+  return quizFile + QStringLiteral(".journal");
+}
+
+QList<Journal::Entry> Journal::read(const QString& quizFile, const Quiz& quiz)
+{
+  QFile file(fileName(quizFile));
+  if( !file.open(QIODevice::ReadOnly) ) {
+    return QList<Entry>();
+  }
+
+  const QByteArray data = file.readAll();
+  const int count       = impl::countRecords(data, impl::solutionHash(quiz));
+
+  QList<Entry> entries;
+  for( int i = 0; i < count; i++ ) {
+    impl::Record r;
+    std::memcpy(&r, data.constData() + sizeof(impl::Header) + std::size_t(i) * sizeof(impl::Record), sizeof(r));
+
+    Entry e;
+    e.action = Action(r.action);
+    e.letter = QChar(r.letter);
+    e.time   = r.time;
+    entries.push_back(e);
+  }
+
+  return entries;
+}
@@ -0,0 +1,374 @@
+/****************************************************************************
+** Copyright (c) 2023, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#include <algorithm>
+
+#include <QtConcurrent/QtConcurrentMap>
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDataStream>
+#include <QtCore/QDateTime>
+#include <QtCore/QDir>
+#include <QtCore/QDirIterator>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QHash>
+#include <QtCore/QSaveFile>
+#include <QtCore/QSet>
+#include <QtCore/QStandardPaths>
+#include <QtCore/QXmlStreamReader>
+
+#include "Library.h"
+
+#include "Data.h"
+#include "PathResolver.h"
+#include "Trace.h"
+
+////// Private ///////////////////////////////////////////////////////////////
+
+namespace impl {
+
+  constexpr quint32 INDEX_MAGIC   = 0x5844494C; // "LIDX"
+  constexpr quint32 INDEX_VERSION = 3;
+
+  QDataStream& operator<<(QDataStream& stream, const LibraryEntry& entry)
+  {
+    stream << entry.path << entry.fileSize << entry.fileTime
+           << entry.error << entry.categories << entry.imageBytes
+           << qint32(entry.images) << qint32(entry.questions) << qint32(entry.solutionLength);
+    return stream;
+  }
+
+  QDataStream& operator>>(QDataStream& stream, LibraryEntry& entry)
+  {
+    qint32 images = 0, questions = 0, solutionLength = 0;
+    stream >> entry.path >> entry.fileSize >> entry.fileTime
+           >> entry.error >> entry.categories >> entry.imageBytes
+           >> images >> questions >> solutionLength;
+    entry.images         = images;
+    entry.questions      = questions;
+    entry.solutionLength = solutionLength;
+    return stream;
+  }
+
+  void countLetters(LibraryEntry& entry, const QString& solution)
+  {
+    const QString s = solution.toUpper().simplified();
+
+    QSet<QChar> letters;
+    for( const QChar& c : s ) {
+      if( c.isLetter() ) {
+        letters.insert(c);
+      }
+    }
+
+    entry.questions      = letters.size();
+    entry.solutionLength = s.size();
+  }
+
+  void addCategory(LibraryEntry& entry, const QString& category)
+  {
+    const QString c = category.trimmed();
+    if( !c.isEmpty() && !entry.categories.contains(c) ) {
+      entry.categories.push_back(c);
+    }
+  }
+
+  void addImage(LibraryEntry& entry, const Image& image)
+  {
+    entry.images++;
+    entry.imageBytes += std::max<qint64>(0, image.fileSize);
+  }
+
+  struct XmlQuestion {
+    QString category{};
+    Images images{};
+  };
+
+  XmlQuestion readQuestion(QXmlStreamReader& xml, PathResolver& resolver)
+  {
+    XmlQuestion result;
+
+    bool have_category = false;
+    while( xml.readNextStartElement() ) {
+      if(        xml.name() == QLatin1String("category") && !have_category ) {
+        result.category = xml.readElementText(QXmlStreamReader::IncludeChildElements);
+        have_category   = true;
+      } else if( xml.name() == QLatin1String("image") ) {
+        Image image;
+        if( resolver.resolve(image, xml.readElementText(QXmlStreamReader::IncludeChildElements)) ) {
+          result.images.push_back(image);
+        }
+      } else {
+        xml.skipCurrentElement();
+      }
+    }
+
+    return result;
+  }
+
+  void parseXml(LibraryEntry& entry)
+  {
+    QFile file(entry.path);
+    if( !file.open(QIODevice::ReadOnly) ) {
+      entry.error = file.errorString();
+      return;
+    }
+
+    PathResolver resolver(entry.path);
+
+    QXmlStreamReader xml(&file);
+    const bool is_quiz = xml.readNextStartElement() && xml.name() == QLatin1String("quiz");
+    if( !is_quiz && !xml.hasError() ) {
+      entry.error = QStringLiteral("Missing <quiz> element!");
+      return;
+    }
+
+    QString solution;
+    bool have_solution = false;
+    QList<XmlQuestion> questions;
+    while( is_quiz && xml.readNextStartElement() ) {
+      if(        xml.name() == QLatin1String("solution") && !have_solution ) {
+        solution      = xml.readElementText(QXmlStreamReader::IncludeChildElements);
+        have_solution = true;
+      } else if( xml.name() == QLatin1String("question") ) {
+        questions.push_back(readQuestion(xml, resolver));
+      } else {
+        xml.skipCurrentElement();
+      }
+    }
+
+    while( !xml.atEnd() ) {
+      xml.readNext();
+    }
+
+    if( xml.hasError() ) {
+      entry.error = QStringLiteral("%1:%2: %3")
+                    .arg(xml.lineNumber())
+                    .arg(xml.columnNumber())
+                    .arg(xml.errorString());
+      return;
+    }
+
+    countLetters(entry, solution);
+    if( entry.questions < 1 ) {
+      entry.error = QStringLiteral("Empty <solution>!");
+      return;
+    }
+
+    const int count = std::min<int>(entry.questions, questions.size());
+    for( int i = 0; i < count; i++ ) {
+      addCategory(entry, questions[i].category);
+      for( const Image& image : questions[i].images ) {
+        addImage(entry, image);
+      }
+    }
+  }
+
+  void parseQuiz(LibraryEntry& entry)
+  {
+    QString errmsg;
+    const Quiz quiz = Quiz::load(entry.path, &errmsg);
+    if( quiz.isEmpty() ) {
+      entry.error = errmsg;
+      return;
+    }
+
+    countLetters(entry, quiz.solution);
+    for( const Question& q : quiz.questions ) {
+      addCategory(entry, q.category);
+      for( const Image& image : q.images ) {
+        addImage(entry, image);
+      }
+    }
+  }
+
+  LibraryEntry parseEntry(const LibraryEntry& known)
+  {
+    TRACE("library::parse");
+
+    LibraryEntry entry;
+    entry.fileSize = known.fileSize;
+    entry.fileTime = known.fileTime;
+    entry.path     = known.path;
+
+    if( entry.path.endsWith(QStringLiteral(".xml"), Qt::CaseInsensitive) ) {
+      parseXml(entry);
+    } else {
+      parseQuiz(entry);
+    }
+
+    return entry;
+  }
+
+} // namespace impl
+
+////// public ////////////////////////////////////////////////////////////////
+
+bool LibraryEntry::isValid() const
+{
+  return error.isEmpty();
+}
+
+namespace library {
+
+  QString indexFile(const QString& rootPath)
+  {
+    const QByteArray key = QCryptographicHash::hash(QDir(rootPath).absolutePath().toUtf8(),
+                                                    QCryptographicHash::Sha1).toHex();
+    const QDir dir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation));
+    return dir.filePath(QStringLiteral("library-%1.idx").arg(QString::fromLatin1(key.left(16))));
+  }
+
+  LibraryEntry parse(const QString& filename)
+  {
+    const QFileInfo info(filename);
+
+    LibraryEntry entry;
+    entry.fileSize = info.size();
+    entry.fileTime = info.lastModified().toMSecsSinceEpoch();
+    entry.path     = info.absoluteFilePath();
+
+    return impl::parseEntry(entry);
+  }
+
+  LibraryEntries readIndex(const QString& rootPath)
+  {
+    QFile file(indexFile(rootPath));
+    if( !file.open(QIODevice::ReadOnly) ) {
+      return LibraryEntries();
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_12);
+
+    quint32 magic = 0, version = 0, count = 0;
+    stream >> magic >> version >> count;
+    if( magic != impl::INDEX_MAGIC || version != impl::INDEX_VERSION ) {
+      return LibraryEntries();
+    }
+
+    LibraryEntries entries;
+    entries.reserve(int(std::min<quint32>(count, 1u << 20)));
+    for( quint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++ ) {
+      LibraryEntry entry;
+      impl::operator>>(stream, entry);
+      entries.push_back(entry);
+    }
+
+    return stream.status() == QDataStream::Ok
+           ? entries
+           : LibraryEntries();
+  }
+
+  LibraryEntries scan(const QString& rootPath, const LibraryEntries& known, int *parsed)
+  {
+    TRACE("library::scan");
+
+    QHash<QString, LibraryEntry> cache;
+    for( const LibraryEntry& entry : known ) {
+      cache.insert(entry.path, entry);
+    }
+
+    // (1) Walk the tree /////////////////////////////////////////////////////
+
+    LibraryEntries entries;
+    LibraryEntries todo;
+    QList<int> todoPos;
+
+    QDirIterator it(rootPath, {QStringLiteral("*.quizpack"), QStringLiteral("*.qzb"), QStringLiteral("*.xml")},
+                    QDir::Files | QDir::Readable, QDirIterator::Subdirectories);
+    while( it.hasNext() ) {
+      it.next();
+      const QFileInfo info = it.fileInfo();
+
+      LibraryEntry entry;
+      entry.fileSize = info.size();
+      entry.fileTime = info.lastModified().toMSecsSinceEpoch();
+      entry.path     = info.absoluteFilePath();
+
+      const auto hit = cache.constFind(entry.path);
+      if( hit != cache.cend()
+          && hit->fileSize == entry.fileSize && hit->fileTime == entry.fileTime ) {
+        entries.push_back(hit.value());
+      } else {
+        todoPos.push_back(entries.size());
+        todo.push_back(entry);
+        entries.push_back(entry);
+      }
+    }
+
+    // (2) Parse changed files on all cores //////////////////////////////////
+
+    const LibraryEntries results = QtConcurrent::blockingMapped<LibraryEntries>(todo, &impl::parseEntry);
+    for( int i = 0; i < results.size(); i++ ) {
+      entries[todoPos[i]] = results[i];
+    }
+
+    if( parsed != nullptr ) {
+      *parsed = results.size();
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const LibraryEntry& a, const LibraryEntry& b) -> bool {
+      return a.path < b.path;
+    });
+
+    return entries;
+  }
+
+  bool writeIndex(const QString& rootPath, const LibraryEntries& entries)
+  {
+    const QString filename = indexFile(rootPath);
+    if( !QDir().mkpath(QFileInfo(filename).absolutePath()) ) {
+      return false;
+    }
+
+    QSaveFile file(filename);
+    if( !file.open(QIODevice::WriteOnly) ) {
+      return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_12);
+
+    stream << impl::INDEX_MAGIC << impl::INDEX_VERSION << quint32(entries.size());
+    for( const LibraryEntry& entry : entries ) {
+      impl::operator<<(stream, entry);
+    }
+
+    if( stream.status() != QDataStream::Ok ) {
+      file.cancelWriting();
+      return false;
+    }
+
+    return file.commit();
+  }
+
+} // namespace library
@@ -0,0 +1,168 @@
+/****************************************************************************
+** Copyright (c) 2023, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#include <QtGui/QBrush>
+#include <QtGui/QPalette>
+#include <QtWidgets/QApplication>
+
+#include "LibraryModel.h"
+
+////// Private ///////////////////////////////////////////////////////////////
+
+namespace impl {
+
+  QString formatBytes(const qint64 bytes)
+  {
+    constexpr double MiB = 1024.0 * 1024.0;
+    return QStringLiteral("%1 MiB").arg(double(bytes) / MiB, 0, 'f', 1);
+  }
+
+} // namespace impl
+
+////// public ////////////////////////////////////////////////////////////////
+
+LibraryModel::LibraryModel(QObject *parent)
+  : QAbstractTableModel(parent)
+{
+}
+
+LibraryModel::~LibraryModel()
+{
+}
+
+int LibraryModel::columnCount(const QModelIndex& /*parent*/) const
+{
+  return NumColumns;
+}
+
+QVariant LibraryModel::data(const QModelIndex& index, int role) const
+{
+  if( !isValidRow(index.row()) ) {
+    return QVariant();
+  }
+
+  const LibraryEntry& e = _entries[index.row()];
+  const int column      = index.column();
+
+  if( role == Qt::DisplayRole || role == SortRole ) {
+    if(        column == FileColumn ) {
+      return _rootDir.relativeFilePath(e.path);
+    } else if( column == CategoriesColumn ) {
+      return e.categories.join(QStringLiteral(", "));
+    } else if( !e.isValid() ) {
+      return QVariant();
+    } else if( column == QuestionsColumn ) {
+      return e.questions;
+    } else if( column == SolutionColumn ) {
+      return e.solutionLength;
+    } else if( column == ImagesColumn ) {
+      return e.images;
+    } else if( column == SizeColumn ) {
+      return role == SortRole
+             ? QVariant(e.imageBytes)
+             : QVariant(impl::formatBytes(e.imageBytes));
+    }
+
+  } else if( role == Qt::TextAlignmentRole ) {
+    return column == FileColumn || column == CategoriesColumn
+           ? int(Qt::AlignLeft | Qt::AlignVCenter)
+           : int(Qt::AlignRight | Qt::AlignVCenter);
+
+  } else if( role == Qt::ForegroundRole ) {
+    if( !e.isValid() ) {
+      return QBrush(QApplication::palette().color(QPalette::Disabled, QPalette::Text));
+    }
+
+  } else if( role == Qt::ToolTipRole ) {
+    return e.isValid()
+           ? QDir::toNativeSeparators(e.path)
+           : e.error;
+  }
+
+  return QVariant();
+}
+
+QVariant LibraryModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+  if( orientation != Qt::Horizontal || role != Qt::DisplayRole ) {
+    return QAbstractTableModel::headerData(section, orientation, role);
+  }
+
+  if(        section == FileColumn ) {
+    return tr("File");
+  } else if( section == QuestionsColumn ) {
+    return tr("Questions");
+  } else if( section == SolutionColumn ) {
+    return tr("Solution");
+  } else if( section == ImagesColumn ) {
+    return tr("Images");
+  } else if( section == SizeColumn ) {
+    return tr("Size");
+  } else if( section == CategoriesColumn ) {
+    return tr("Categories");
+  }
+
+  return QVariant();
+}
+
+int LibraryModel::rowCount(const QModelIndex& parent) const
+{
+  return parent.isValid()
+         ? 0
+         : _entries.size();
+}
+
+LibraryEntries LibraryModel::entries() const
+{
+  return _entries;
+}
+
+LibraryEntry LibraryModel::entry(const int row) const
+{
+  return isValidRow(row)
+         ? _entries[row]
+         : LibraryEntry();
+}
+
+void LibraryModel::setEntries(const QString& rootPath, const LibraryEntries& entries)
+{
+  beginResetModel();
+  _entries = entries;
+  _rootDir = QDir(rootPath);
+  endResetModel();
+}
+
+////// private ///////////////////////////////////////////////////////////////
+
+bool LibraryModel::isValidRow(const int row) const
+{
+  return row >= 0 && row < _entries.size();
+}
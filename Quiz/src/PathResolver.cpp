@@ -0,0 +1,114 @@
+/****************************************************************************
+** Copyright (c) 2023, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#include <QtCore/QDateTime>
+#include <QtCore/QFileInfo>
+
+#include "PathResolver.h"
+
+#include "Image.h"
+
+////// Private ///////////////////////////////////////////////////////////////
+
+namespace impl {
+
+  inline QString fileKey(const QString& name)
+  {
+#if defined(Q_OS_WIN) || defined(Q_OS_MACOS)
+    return name.toCaseFolded();
+#else
+    return name;
+#endif
+  }
+
+} // namespace impl
+
+////// public ////////////////////////////////////////////////////////////////
+
+PathResolver::PathResolver(const QString& basePath)
+  : _baseDir{QFileInfo(basePath).absoluteDir()}
+{
+}
+
+PathResolver::~PathResolver()
+{
+}
+
+bool PathResolver::resolve(Image& image, const QString& imagePath)
+{
+  if( imagePath.isEmpty() ) {
+    return false;
+  }
+
+  QString path;
+  if(        lookup(QFileInfo(imagePath).absoluteFilePath()) ) {
+    path = imagePath;
+  } else if( lookup(QFileInfo(_baseDir, imagePath).absoluteFilePath()) ) {
+    path = QFileInfo(_baseDir, imagePath).absoluteFilePath();
+  } else {
+    return false;
+  }
+
+  const QFileInfo info(path);
+  if( !info.exists() ) {
+    return false;
+  }
+
+  image.path     = path;
+  image.fileSize = info.size();
+  image.fileTime = info.lastModified().toMSecsSinceEpoch();
+
+  return true;
+}
+
+////// private ///////////////////////////////////////////////////////////////
+
+bool PathResolver::lookup(const QString& absPath)
+{
+  const int sep = absPath.lastIndexOf(QChar::fromLatin1('/'));
+  if( sep < 0 ) {
+    return false;
+  }
+
+  const QString dirPath = absPath.left(sep + 1);
+
+  auto it = _listings.find(dirPath);
+  if( it == _listings.end() ) {
+    QSet<QString> names;
+    const QStringList entries = QDir(dirPath).entryList(QDir::Files | QDir::Hidden | QDir::System);
+    for( const QString& entry : entries ) {
+      names.insert(impl::fileKey(entry));
+    }
+    it = _listings.insert(dirPath, names);
+  }
+
+  return it.value().contains(impl::fileKey(absPath.mid(sep + 1)));
+}
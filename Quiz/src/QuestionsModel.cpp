@@ -29,15 +29,70 @@
 ** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 *****************************************************************************/
 
+#include <algorithm>
+
 #include <QtGui/QFont>
+#include <QtGui/QFontMetrics>
+#include <QtGui/QPainter>
+#include <QtGui/QPixmap>
 #include <QtWidgets/QApplication>
 
 #include "questionsmodel.h"
 
+#include "Trace.h"
 #include "util.h"
 #include "wimageviewer.h"
 #include "wquestion.h"
 
+////// Private ///////////////////////////////////////////////////////////////
+
+namespace impl {
+
+  QPixmap makeBadge(const int count, const QFont& font)
+  {
+    const int size = QFontMetrics(font).height();
+
+    QPixmap badge(size, size);
+    badge.fill(Qt::transparent);
+
+    QFont f = font;
+    f.setPointSize(std::max<int>(1, font.pointSize() / 2));
+
+    const QPalette palette = QApplication::palette();
+
+    QPainter painter(&badge);
+    painter.setRenderHint(QPainter::Antialiasing, true);
+    painter.setPen(Qt::NoPen);
+    painter.setBrush(palette.color(QPalette::Highlight));
+    painter.drawEllipse(badge.rect().adjusted(1, 1, -1, -1));
+    painter.setFont(f);
+    painter.setPen(palette.color(QPalette::HighlightedText));
+    painter.drawText(badge.rect(), Qt::AlignCenter, QString::number(count));
+
+    return badge;
+  }
+
+  bool isSameImage(const Image& a, const Image& b)
+  {
+    return a.path == b.path
+           && a.fileTime == b.fileTime
+           && a.rotate == b.rotate
+           && a.flipH == b.flipH
+           && a.flipV == b.flipV
+           && a.bgColor == b.bgColor;
+  }
+
+  bool isSameQuestion(const Question& a, const Question& b)
+  {
+    return a.answer == b.answer
+           && a.category == b.category
+           && a.question == b.question
+           && std::equal(a.images.cbegin(), a.images.cend(),
+                         b.images.cbegin(), b.images.cend(), isSameImage);
+  }
+
+} // namespace impl
+
 ////// public ////////////////////////////////////////////////////////////////
 
 QuestionsModel::QuestionsModel(QObject *parent)
@@ -51,67 +106,239 @@ QuestionsModel::~QuestionsModel()
 
 QVariant QuestionsModel::data(const QModelIndex& index, int role) const
 {
+  if( !isValidRow(index.row()) ) {
+    return QVariant();
+  }
+
+  const Row& row = _rows[index.row()];
+
   if( role == Qt::FontRole ) {
-    QFont font = QApplication::font();
-    font.setBold(true);
-    font.setPointSize(_fontSize);
-    return font;
+    return _font;
 
   } else if( role == Qt::TextAlignmentRole ) {
-    return int(Qt::AlignHCenter | Qt::AlignVCenter);
+    return _alignment;
 
   } else if( role == Qt::DisplayRole ) {
-    const auto it = std::next(_questions.begin(), index.row());
-    return it->category;
+    return row.display;
+
+  } else if( role == Qt::DecorationRole ) {
+    return row.decoration;
+
+  } else if( role == Qt::ToolTipRole ) {
+    return row.toolTip;
   }
 
   return QVariant();
 }
 
-Qt::ItemFlags QuestionsModel::flags(const QModelIndex& /*index*/) const
+Qt::ItemFlags QuestionsModel::flags(const QModelIndex& index) const
 {
-  return Qt::ItemIsEnabled;
+  return isAnswered(index.row())
+         ? Qt::NoItemFlags
+         : Qt::ItemIsEnabled;
 }
 
 int QuestionsModel::rowCount(const QModelIndex& /*parent*/) const
 {
-  return _questions.size();
+  return _rows.size();
+}
+
+QSet<QChar> QuestionsModel::answeredLetters() const
+{
+  return _answered;
+}
+
+bool QuestionsModel::isAnswered(const int row) const
+{
+  return isValidRow(row) && _rows[row].answered;
+}
+
+void QuestionsModel::setAnswered(const int row)
+{
+  if( !isValidRow(row) || _rows[row].answered ) {
+    return;
+  }
+
+  const QChar letter = _rows[row].question.letter;
+  markAnswered(row);
+
+  emit answered(letter);
+}
+
+void QuestionsModel::setAnsweredLetter(const QChar& c)
+{
+  for( int row = 0; row < _rows.size(); row++ ) {
+    if( _rows[row].question.letter == c ) {
+      setAnswered(row);
+      return;
+    }
+  }
+}
+
+bool QuestionsModel::keepAnswered() const
+{
+  return _keepAnswered;
+}
+
+void QuestionsModel::setDocumentCache(DocumentCache *docs)
+{
+  _docs = docs;
+}
+
+void QuestionsModel::setQuestionDialog(WQuestion *dialog)
+{
+  _dialog = dialog;
+}
+
+void QuestionsModel::setKeepAnswered(const bool on)
+{
+  _keepAnswered = on;
+
+  if( _keepAnswered ) {
+    return;
+  }
+
+  for( int row = _rows.size() - 1; row >= 0; row-- ) {
+    if( _rows[row].answered ) {
+      beginRemoveRows(QModelIndex(), row, row);
+      _rows.remove(row);
+      endRemoveRows();
+    }
+  }
 }
 
 void QuestionsModel::setQuestions(const Quiz& quiz)
 {
   beginResetModel();
-  _fontSize  = quiz.fontSize;
-  _questions = quiz.questions;
+
+  _fontSize = quiz.fontSize;
+
+  QFont font = QApplication::font();
+  font.setBold(true);
+  font.setPointSize(_fontSize);
+
+  _alignment = int(Qt::AlignHCenter | Qt::AlignVCenter);
+  _answered.clear();
+  _badges.clear();
+  _font = font;
+
+  _rows.clear();
+  _rows.reserve(quiz.questions.size());
+  for( const Question& q : quiz.questions ) {
+    Row row;
+    row.question = q;
+    setupRow(row);
+    _rows.push_back(row);
+  }
+
   endResetModel();
 }
 
+void QuestionsModel::updateQuestions(const Quiz& quiz)
+{
+  QHash<QChar,int> rows;
+  for( int i = 0; i < _rows.size(); i++ ) {
+    rows.insert(_rows[i].question.letter, i);
+  }
+
+  QSet<QChar> letters;
+  for( const Question& q : quiz.questions ) {
+    letters.insert(q.letter);
+  }
+
+  QSet<QChar> known = _answered;
+  for( const Row& row : qAsConst(_rows) ) {
+    known.insert(row.question.letter);
+  }
+
+  if( letters != known || quiz.fontSize != _fontSize ) {
+    const QSet<QChar> answered = _answered;
+    setQuestions(quiz);
+    for( int row = _rows.size() - 1; row >= 0; row-- ) {
+      if( answered.contains(_rows[row].question.letter) ) {
+        markAnswered(row);
+      }
+    }
+    return;
+  }
+
+  for( const Question& q : quiz.questions ) {
+    const int row = rows.value(q.letter, -1);
+    if( row < 0 || impl::isSameQuestion(_rows[row].question, q) ) {
+      continue;
+    }
+
+    _rows[row].question = q;
+    setupRow(_rows[row]);
+    emit dataChanged(index(row), index(row));
+  }
+}
+
 ////// public slots //////////////////////////////////////////////////////////
 
 void QuestionsModel::activate(const QModelIndex& index)
 {
-  if( !index.isValid() || index.row() < 0 || index.row() >= _questions.size() ) {
+  TRACE("QuestionsModel::activate");
+
+  if( !index.isValid() || !isValidRow(index.row()) || isAnswered(index.row())
+      || _dialog == nullptr || _docs == nullptr ) {
     return;
   }
 
-  auto it = std::next(_questions.begin(), index.row());
-
-  WQuestion d(dynamic_cast<QWidget *>(parent()));
-  d.setQuestion(_fontSize, *it);
-  d.resize(800, 600);
+  const Question& q = _rows[index.row()].question;
 
-  if( d.exec() != QDialog::Accepted ) {
+  _dialog->setQuestion(q, _docs);
+  if( _dialog->exec() != QDialog::Accepted ) {
     return;
   }
 
-  emit uncovered(it->letter);
+  emit uncovered(q.letter);
 
-  if( !it->images.empty() ) {
-    WImageViewer *viewer = new WImageViewer(it->images);
+  if( !q.images.empty() ) {
+    WImageViewer *viewer = new WImageViewer(q.images);
     viewer->showMaximized();
   }
 
-  beginResetModel();
-  _questions.erase(it);
-  endResetModel();
+  setAnswered(index.row());
+}
+
+////// private ///////////////////////////////////////////////////////////////
+
+bool QuestionsModel::isValidRow(const int row) const
+{
+  return row >= 0 && row < _rows.size();
+}
+
+void QuestionsModel::markAnswered(const int row)
+{
+  _answered.insert(_rows[row].question.letter);
+
+  if( _keepAnswered ) {
+    _rows[row].answered = true;
+    emit dataChanged(index(row), index(row));
+  } else {
+    beginRemoveRows(QModelIndex(), row, row);
+    _rows.remove(row);
+    endRemoveRows();
+  }
+}
+
+void QuestionsModel::setupRow(Row& row)
+{
+  const int count = int(row.question.images.size());
+
+  row.display = row.question.category;
+
+  if( count > 0 ) {
+    auto badge = _badges.find(count);
+    if( badge == _badges.end() ) {
+      badge = _badges.insert(count, impl::makeBadge(count, _font.value<QFont>()));
+    }
+
+    row.decoration = badge.value();
+    row.toolTip    = tr("%n image(s)", nullptr, count);
+  } else {
+    row.decoration = QVariant();
+    row.toolTip    = QVariant();
+  }
 }
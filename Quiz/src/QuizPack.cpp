@@ -0,0 +1,425 @@
+/****************************************************************************
+** Copyright (c) 2023, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#include <limits>
+#include <type_traits>
+
+#include <QtCore/QBuffer>
+#include <QtCore/QDateTime>
+#include <QtCore/QDir>
+#include <QtCore/QFileInfo>
+#include <QtCore/QSaveFile>
+#include <QtCore/QVector>
+
+#include "QuizPack.h"
+
+#include "Data.h"
+
+#include "Trace.h"
+
+////// Private ///////////////////////////////////////////////////////////////
+
+namespace priv {
+
+  namespace qzp {
+
+    /*
+     * NOTE: A quiz pack is laid out as follows (native byte order):
+     *
+     * Header
+     * Entry[Header::numEntries]
+     * char16_t[Header::numChars]      // Names; UTF-16
+     * char[]                          // Data; cf. Entry::offset
+     */
+
+    constexpr quint32 MAGIC   = 0x4B505A51; // "QZPK"; detects byte order, too
+    constexpr quint32 VERSION = 1;
+
+    const QString QUIZ_ENTRY = QStringLiteral("quiz.xml");
+
+    struct String {
+      quint32 offset{0}; // in char16_t
+      quint32 length{0}; // in char16_t
+    };
+
+    struct Header {
+      quint32 magic{MAGIC};
+      quint32 version{VERSION};
+      quint32 numEntries{0};
+      quint32 numChars{0};
+    };
+
+    struct Entry {
+      qint64 offset{0}; // in bytes; relative to the start of the file
+      qint64 size{0};   // in bytes
+      String name{};
+    };
+
+    static_assert(std::is_trivially_copyable_v<Header> && sizeof(Header) == 16);
+    static_assert(std::is_trivially_copyable_v<Entry> && sizeof(Entry) == 24);
+
+    void setError(QString *errmsg, const QString& filename, const QString& what)
+    {
+      if( errmsg != nullptr ) {
+        *errmsg = QStringLiteral("%1: %2").arg(filename, what);
+      }
+    }
+
+  } // namespace qzp
+
+} // namespace priv
+
+////// public ////////////////////////////////////////////////////////////////
+
+QuizPack::~QuizPack() = default;
+
+bool QuizPack::contains(const QString& path) const
+{
+  return find(path) != nullptr;
+}
+
+QByteArray QuizPack::data(const QString& path) const
+{
+  const Blob *blob = find(path);
+  if( blob == nullptr ) {
+    return QByteArray();
+  }
+
+  return QByteArray::fromRawData(reinterpret_cast<const char *>(_data + blob->offset), int(blob->size));
+}
+
+QString QuizPack::fileName() const
+{
+  return _file.fileName();
+}
+
+QString QuizPack::filePath(const QString& name) const
+{
+  return _prefix + name;
+}
+
+qint64 QuizPack::fileTime() const
+{
+  return _fileTime;
+}
+
+qint64 QuizPack::size(const QString& path) const
+{
+  const Blob *blob = find(path);
+  return blob != nullptr
+         ? blob->size
+         : -1;
+}
+
+std::shared_ptr<const QuizPack> QuizPack::open(const QString& filename, QString *errmsg)
+{
+  TRACE("QuizPack::open");
+
+  using namespace priv;
+
+  if( errmsg != nullptr ) {
+    errmsg->clear();
+  }
+
+  const QFileInfo info(filename);
+
+  std::shared_ptr<QuizPack> pack(new QuizPack());
+  pack->_file.setFileName(info.absoluteFilePath());
+  pack->_fileTime = info.lastModified().toMSecsSinceEpoch();
+  pack->_prefix   = info.absoluteFilePath() + QChar::fromLatin1('/');
+
+  if( !pack->_file.open(QIODevice::ReadOnly) ) {
+    qzp::setError(errmsg, filename, pack->_file.errorString());
+    return nullptr;
+  }
+
+  const qint64 size = pack->_file.size();
+  pack->_data = size >= qint64(sizeof(qzp::Header))
+                ? pack->_file.map(0, size)
+                : nullptr;
+  if( pack->_data == nullptr ) {
+    qzp::setError(errmsg, filename, QStringLiteral("Unable to map quiz pack!"));
+    return nullptr;
+  }
+
+  // (1) Sections ////////////////////////////////////////////////////////////
+
+  const qzp::Header *header = reinterpret_cast<const qzp::Header *>(pack->_data);
+  if( header->magic != qzp::MAGIC || header->version != qzp::VERSION ) {
+    qzp::setError(errmsg, filename, QStringLiteral("Invalid or outdated quiz pack!"));
+    return nullptr;
+  }
+
+  const quint64 required = quint64(sizeof(qzp::Header))
+                           + quint64(header->numEntries) * sizeof(qzp::Entry)
+                           + quint64(header->numChars) * sizeof(char16_t);
+  if( quint64(size) < required ) {
+    qzp::setError(errmsg, filename, QStringLiteral("Truncated quiz pack!"));
+    return nullptr;
+  }
+
+  const auto *rec_entries = reinterpret_cast<const qzp::Entry *>(header + 1);
+  const auto *chars       = reinterpret_cast<const QChar *>(rec_entries + header->numEntries);
+
+  // (2) Index ///////////////////////////////////////////////////////////////
+
+  pack->_index.reserve(int(header->numEntries));
+  for( quint32 i = 0; i < header->numEntries; i++ ) {
+    const qzp::Entry& rec = rec_entries[i];
+
+    const bool is_valid = quint64(rec.name.offset) + quint64(rec.name.length) <= header->numChars
+                          && rec.offset >= 0 && rec.offset <= size
+                          && rec.size >= 0 && rec.size <= size - rec.offset
+                          && rec.size <= std::numeric_limits<int>::max();
+    if( !is_valid ) {
+      qzp::setError(errmsg, filename, QStringLiteral("Corrupt quiz pack!"));
+      return nullptr;
+    }
+
+    const QString name(chars + rec.name.offset, int(rec.name.length));
+    if( name.isEmpty() || pack->_index.contains(name) ) {
+      qzp::setError(errmsg, filename, QStringLiteral("Corrupt quiz pack!"));
+      return nullptr;
+    }
+
+    pack->_index.insert(name, Blob{rec.offset, rec.size});
+  }
+
+  return pack;
+}
+
+bool QuizPack::write(const QString& filename, const QList<Entry>& entries, QString *errmsg)
+{
+  using namespace priv;
+
+  if( errmsg != nullptr ) {
+    errmsg->clear();
+  }
+
+  // (1) Index; the data follows the names ///////////////////////////////////
+
+  QVector<qint64> sizes;
+  sizes.reserve(entries.size());
+  for( const Entry& entry : entries ) {
+    if( entry.data.isNull() && !QFileInfo::exists(entry.source) ) {
+      qzp::setError(errmsg, entry.source, QStringLiteral("No such file!"));
+      return false;
+    }
+    sizes.push_back(entry.data.isNull()
+                    ? QFileInfo(entry.source).size()
+                    : qint64(entry.data.size()));
+  }
+
+  QString chars;
+  for( const Entry& entry : entries ) {
+    chars += entry.name;
+  }
+
+  qzp::Header header;
+  header.numEntries = quint32(entries.size());
+  header.numChars   = quint32(chars.size());
+
+  QVector<qzp::Entry> index;
+  index.reserve(entries.size());
+
+  qint64 offset    = qint64(sizeof(qzp::Header))
+                     + qint64(header.numEntries) * qint64(sizeof(qzp::Entry))
+                     + qint64(header.numChars) * qint64(sizeof(char16_t));
+  quint32 numChars = 0;
+  for( int i = 0; i < entries.size(); i++ ) {
+    qzp::Entry rec;
+    rec.offset      = offset;
+    rec.size        = sizes[i];
+    rec.name.offset = numChars;
+    rec.name.length = quint32(entries[i].name.size());
+    index.push_back(rec);
+
+    offset   += rec.size;
+    numChars += rec.name.length;
+  }
+
+  // (2) Output //////////////////////////////////////////////////////////////
+
+  QSaveFile file(filename);
+  if( !file.open(QIODevice::WriteOnly) ) {
+    qzp::setError(errmsg, filename, file.errorString());
+    return false;
+  }
+
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char *>(index.constData()),
+             qint64(index.size()) * qint64(sizeof(qzp::Entry)));
+  file.write(reinterpret_cast<const char *>(chars.utf16()),
+             qint64(chars.size()) * qint64(sizeof(char16_t)));
+
+  for( int i = 0; i < entries.size(); i++ ) {
+    const Entry& entry = entries[i];
+    if( !entry.data.isNull() ) {
+      file.write(entry.data);
+      continue;
+    }
+
+    QFile source(entry.source);
+    if( !source.open(QIODevice::ReadOnly) ) {
+      qzp::setError(errmsg, entry.source, source.errorString());
+      file.cancelWriting();
+      return false;
+    }
+
+    const QByteArray data = source.readAll();
+    if( qint64(data.size()) != sizes[i] ) {
+      qzp::setError(errmsg, entry.source, QStringLiteral("File changed while packing!"));
+      file.cancelWriting();
+      return false;
+    }
+    file.write(data);
+  }
+
+  if( !file.commit() ) {
+    qzp::setError(errmsg, filename, file.errorString());
+    return false;
+  }
+
+  return true;
+}
+
+////// private ///////////////////////////////////////////////////////////////
+
+const QuizPack::Blob *QuizPack::find(const QString& path) const
+{
+  if( !path.startsWith(_prefix) ) {
+    return nullptr;
+  }
+
+  const auto hit = _index.constFind(path.mid(_prefix.size()));
+  return hit != _index.cend()
+         ? &hit.value()
+         : nullptr;
+}
+
+////// Quiz //////////////////////////////////////////////////////////////////
+
+bool Quiz::writePack(const QString& filename, QString *errmsg) const
+{
+  using namespace priv;
+
+  if( isEmpty() ) {
+    qzp::setError(errmsg, filename, QStringLiteral("Empty quiz!"));
+    return false;
+  }
+
+  // (1) Images; each file is stored once ////////////////////////////////////
+
+  QList<QuizPack::Entry> entries;
+  QHash<QString,QString> names; // path -> name
+  for( const Question& q : questions ) {
+    for( const Image& image : q.images ) {
+      if( names.contains(image.path) ) {
+        continue;
+      }
+
+      QuizPack::Entry entry;
+      entry.name = QStringLiteral("images/%1").arg(names.size() + 1, 4, 10, QChar::fromLatin1('0'));
+
+      const QString suffix = QFileInfo(image.path).suffix().toLower();
+      if( !suffix.isEmpty() ) {
+        entry.name += QChar::fromLatin1('.') + suffix;
+      }
+
+      if( image.pack ) {
+        entry.data = image.pack->data(image.path);
+      } else {
+        entry.source = image.path;
+      }
+
+      names.insert(image.path, entry.name);
+      entries.push_back(entry);
+    }
+  }
+
+  // (2) Quiz; referring to the images by name ///////////////////////////////
+
+  QByteArray xml;
+  QBuffer buffer(&xml);
+  buffer.open(QIODevice::WriteOnly);
+
+  const auto name = [&names](const Image& image) -> QString {
+    return names.value(image.path);
+  };
+
+  if( !write(&buffer, name) ) {
+    qzp::setError(errmsg, filename, QStringLiteral("Unable to write quiz!"));
+    return false;
+  }
+  buffer.close();
+
+  entries.push_front(QuizPack::Entry{qzp::QUIZ_ENTRY, xml, QString()});
+
+  return QuizPack::write(filename, entries, errmsg);
+}
+
+Quiz Quiz::readPack(const QString& filename, QString *errmsg)
+{
+  TRACE("Quiz::readPack");
+
+  using namespace priv;
+
+  const std::shared_ptr<const QuizPack> pack = QuizPack::open(filename, errmsg);
+  if( !pack ) {
+    return Quiz();
+  }
+
+  QByteArray xml = pack->data(pack->filePath(qzp::QUIZ_ENTRY));
+  if( xml.isEmpty() ) {
+    qzp::setError(errmsg, filename, QStringLiteral("Missing %1!").arg(qzp::QUIZ_ENTRY));
+    return Quiz();
+  }
+
+  QBuffer buffer(&xml);
+  buffer.open(QIODevice::ReadOnly);
+
+  const auto resolve = [&pack](Image& image, const QString& name) -> bool {
+    const QString path = pack->filePath(QDir::cleanPath(name));
+    const qint64 size  = pack->size(path);
+    if( size < 0 ) {
+      return false;
+    }
+
+    image.fileSize = size;
+    image.fileTime = pack->fileTime();
+    image.pack     = pack;
+    image.path     = path;
+
+    return true;
+  };
+
+  return read(&buffer, filename, resolve, errmsg);
+}
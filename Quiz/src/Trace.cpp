@@ -0,0 +1,242 @@
+/****************************************************************************
+** Copyright (c) 2023, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QMutex>
+#include <QtCore/QSaveFile>
+#include <QtCore/QThread>
+
+#include "Trace.h"
+
+////// Private ///////////////////////////////////////////////////////////////
+
+namespace trace {
+
+  namespace impl {
+
+    using Clock = std::chrono::steady_clock;
+
+    constexpr quint64 CAPACITY = 1 << 16; // Events per thread
+
+    // Seqlock: seq is 0 while the slot is written, n+1 once it holds event n.
+    struct Event {
+      std::atomic<quint64> seq{0};
+      std::atomic<const char *> name{nullptr};
+      std::atomic<qint64> begin{0};
+      std::atomic<qint64> end{0};
+    };
+
+    struct Snapshot {
+      const char *name{nullptr};
+      qint64 begin{0};
+      qint64 end{0};
+    };
+
+    struct Buffer {
+      std::unique_ptr<Event[]> events{new Event[CAPACITY]};
+      std::atomic<quint64> count{0};
+      QString name{};
+      int tid{0};
+    };
+
+    const Clock::time_point epoch = Clock::now();
+
+    QMutex mutex;
+    std::vector<std::unique_ptr<Buffer>> buffers;
+    QString filename;
+
+    Buffer *buffer()
+    {
+      thread_local Buffer *local = nullptr;
+      if( local == nullptr ) {
+        const QString name = QThread::currentThread()->objectName();
+        const bool is_main = QCoreApplication::instance() != nullptr
+                             && QCoreApplication::instance()->thread() == QThread::currentThread();
+
+        QMutexLocker locker(&mutex);
+        buffers.push_back(std::make_unique<Buffer>());
+        local       = buffers.back().get();
+        local->tid  = int(buffers.size());
+
+        if(        is_main ) {
+          local->name = QStringLiteral("Main");
+        } else if( name.isEmpty() ) {
+          local->name = QStringLiteral("Thread %1").arg(local->tid);
+        } else {
+          local->name = QStringLiteral("%1 %2").arg(name).arg(local->tid);
+        }
+      }
+      return local;
+    }
+
+    qint64 now()
+    {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - epoch).count();
+    }
+
+    void record(const char *name, const qint64 begin, const qint64 end)
+    {
+      Buffer *b       = buffer();
+      const quint64 n = b->count.load(std::memory_order_relaxed);
+
+      Event& e = b->events[n % CAPACITY];
+      e.seq.store(0, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+      e.name.store(name, std::memory_order_relaxed);
+      e.begin.store(begin, std::memory_order_relaxed);
+      e.end.store(end, std::memory_order_relaxed);
+      e.seq.store(n + 1, std::memory_order_release);
+
+      b->count.store(n + 1, std::memory_order_release);
+    }
+
+    bool read(const Event& e, const quint64 n, Snapshot& snapshot)
+    {
+      const quint64 seq = e.seq.load(std::memory_order_acquire);
+      if( seq != n + 1 ) {
+        return false;
+      }
+
+      snapshot.name  = e.name.load(std::memory_order_relaxed);
+      snapshot.begin = e.begin.load(std::memory_order_relaxed);
+      snapshot.end   = e.end.load(std::memory_order_relaxed);
+
+      std::atomic_thread_fence(std::memory_order_acquire);
+      return e.seq.load(std::memory_order_relaxed) == seq;
+    }
+
+    QJsonObject threadName(const Buffer& b)
+    {
+      QJsonObject args;
+      args.insert(QStringLiteral("name"), b.name);
+
+      QJsonObject event;
+      event.insert(QStringLiteral("args"), args);
+      event.insert(QStringLiteral("name"), QStringLiteral("thread_name"));
+      event.insert(QStringLiteral("ph"), QStringLiteral("M"));
+      event.insert(QStringLiteral("pid"), 1);
+      event.insert(QStringLiteral("tid"), b.tid);
+      return event;
+    }
+
+    QJsonObject completeEvent(const Buffer& b, const Snapshot& e)
+    {
+      QJsonObject event;
+      event.insert(QStringLiteral("dur"), double(e.end - e.begin) / 1000.0);
+      event.insert(QStringLiteral("name"), QString::fromUtf8(e.name));
+      event.insert(QStringLiteral("ph"), QStringLiteral("X"));
+      event.insert(QStringLiteral("pid"), 1);
+      event.insert(QStringLiteral("tid"), b.tid);
+      event.insert(QStringLiteral("ts"), double(e.begin) / 1000.0);
+      return event;
+    }
+
+    void finish()
+    {
+      if( !stop() ) {
+        std::fprintf(stderr, "%s: Unable to write trace!\n", qPrintable(filename));
+      }
+    }
+
+  } // namespace impl
+
+////// public ////////////////////////////////////////////////////////////////
+
+  void setup(QStringList& args)
+  {
+    QString filename = qEnvironmentVariable("QUIZ_TRACE");
+
+    const int at = args.indexOf(QStringLiteral("-trace"));
+    if( at > 0 && at + 1 < args.size() ) {
+      filename = args[at + 1];
+      args.erase(args.begin() + at, args.begin() + at + 2);
+    }
+
+    if( filename.isEmpty() ) {
+      return;
+    }
+
+    start(filename);
+    qAddPostRoutine(&impl::finish);
+  }
+
+  void start(const QString& filename)
+  {
+    {
+      QMutexLocker locker(&impl::mutex);
+      impl::filename = filename;
+    }
+    impl::enabled.store(true, std::memory_order_relaxed);
+  }
+
+  bool stop()
+  {
+    if( !impl::enabled.exchange(false) ) {
+      return true;
+    }
+
+    QMutexLocker locker(&impl::mutex);
+
+    QJsonArray events;
+    for( const auto& b : impl::buffers ) {
+      events.push_back(impl::threadName(*b));
+
+      const quint64 count = b->count.load(std::memory_order_acquire);
+      const quint64 first = count > impl::CAPACITY
+                            ? count - impl::CAPACITY
+                            : 0;
+      for( quint64 i = first; i < count; i++ ) {
+        impl::Snapshot e;
+        if( impl::read(b->events[i % impl::CAPACITY], i, e) ) {
+          events.push_back(impl::completeEvent(*b, e));
+        }
+      }
+    }
+
+    QJsonObject root;
+    root.insert(QStringLiteral("displayTimeUnit"), QStringLiteral("ms"));
+    root.insert(QStringLiteral("traceEvents"), events);
+
+    QSaveFile file(impl::filename);
+    return file.open(QIODevice::WriteOnly)
+           && file.write(QJsonDocument(root).toJson(QJsonDocument::Compact)) >= 0
+           && file.commit();
+  }
+
+} // namespace trace
@@ -29,31 +29,213 @@
 ** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 *****************************************************************************/
 
+#include <algorithm>
+#include <cstring>
+
 #include <QtGui/QImage>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# define HAVE_SSE2
+# include <emmintrin.h>
+#endif
+
 #include "util.h"
 
-namespace util {
+#include "Trace.h"
 
-  QImage rotated(const QImage& image, const int angle)
+////// Private ///////////////////////////////////////////////////////////////
+
+namespace impl {
+
+  // Output pixel (x,y) is read from source + start + x*stepX + y*stepY.
+  struct Mapping {
+    qptrdiff start{0};
+    qptrdiff stepX{4};
+    qptrdiff stepY{0};
+    bool transposed{false};
+  };
+
+  constexpr int TILE = 64;
+
+  Mapping mapping(const QImage& src, const int angle, const bool flipH, const bool flipV)
   {
-    qreal COS{1}, SIN{0};
+    const int W = src.width();
+    const int H = src.height();
 
+    // Source coordinates (sx,sy) = (cx + x*axx + y*axy, cy + x*ayx + y*ayy)
+    int cx = 0, axx = 1, axy = 0;
+    int cy = 0, ayx = 0, ayy = 1;
     if(        angle ==  90 ) {
-      COS = 0;
-      SIN = 1;
+      cx  = W - 1;
+      axx = 0;
+      axy = -1;
+      cy  = 0;
+      ayx = 1;
+      ayy = 0;
     } else if( angle == 180 ) {
-      COS = -1;
-      SIN =  0;
+      cx  = W - 1;
+      axx = -1;
+      axy = 0;
+      cy  = H - 1;
+      ayx = 0;
+      ayy = -1;
     } else if( angle == 270 ) {
-      COS =  0;
-      SIN = -1;
+      cx  = 0;
+      axx = 0;
+      axy = 1;
+      cy  = H - 1;
+      ayx = -1;
+      ayy = 0;
+    }
+
+    if( flipH ) {
+      cx  = W - 1 - cx;
+      axx = -axx;
+      axy = -axy;
+    }
+    if( flipV ) {
+      cy  = H - 1 - cy;
+      ayx = -ayx;
+      ayy = -ayy;
+    }
+
+    const qptrdiff stride = src.bytesPerLine();
+
+    Mapping m;
+    m.start      = qptrdiff(cy) * stride + qptrdiff(cx) * 4;
+    m.stepX      = qptrdiff(ayx) * stride + qptrdiff(axx) * 4;
+    m.stepY      = qptrdiff(ayy) * stride + qptrdiff(axy) * 4;
+    m.transposed = angle == 90 || angle == 270;
+    return m;
+  }
+
+  inline void copyBlock(const uchar *src, const Mapping& m,
+                        uchar *dst, const qptrdiff dstStride,
+                        const int x0, const int y0, const int w, const int h)
+  {
+    for( int y = y0; y < y0 + h; y++ ) {
+      const uchar *s = src + m.start + qptrdiff(y) * m.stepY + qptrdiff(x0) * m.stepX;
+      quint32 *d     = reinterpret_cast<quint32 *>(dst + qptrdiff(y) * dstStride) + x0;
+      for( int x = 0; x < w; x++, s += m.stepX ) {
+        d[x] = *reinterpret_cast<const quint32 *>(s);
+      }
     }
+  }
+
+#ifdef HAVE_SSE2
+  inline void transpose4x4(const uchar *s, const Mapping& m,
+                           uchar *d, const qptrdiff dstStride)
+  {
+    __m128i c[4];
+    for( int i = 0; i < 4; i++, s += m.stepX ) {
+      if( m.stepY > 0 ) {
+        c[i] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s));
+      } else {
+        c[i] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + 3 * m.stepY));
+        c[i] = _mm_shuffle_epi32(c[i], _MM_SHUFFLE(0, 1, 2, 3));
+      }
+    }
+
+    const __m128i t0 = _mm_unpacklo_epi32(c[0], c[1]);
+    const __m128i t1 = _mm_unpacklo_epi32(c[2], c[3]);
+    const __m128i t2 = _mm_unpackhi_epi32(c[0], c[1]);
+    const __m128i t3 = _mm_unpackhi_epi32(c[2], c[3]);
+
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(d), _mm_unpacklo_epi64(t0, t1));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(d + dstStride), _mm_unpackhi_epi64(t0, t1));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(d + 2 * dstStride), _mm_unpacklo_epi64(t2, t3));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(d + 3 * dstStride), _mm_unpackhi_epi64(t2, t3));
+  }
+#endif
+
+  void transposeTile(const uchar *src, const Mapping& m,
+                     uchar *dst, const qptrdiff dstStride,
+                     const int x0, const int y0, const int w, const int h)
+  {
+    int y = y0;
+#ifdef HAVE_SSE2
+    for( ; y + 4 <= y0 + h; y += 4 ) {
+      int x = x0;
+      for( ; x + 4 <= x0 + w; x += 4 ) {
+        transpose4x4(src + m.start + qptrdiff(y) * m.stepY + qptrdiff(x) * m.stepX, m,
+                     dst + qptrdiff(y) * dstStride + qptrdiff(x) * 4, dstStride);
+      }
+      copyBlock(src, m, dst, dstStride, x, y, x0 + w - x, 4);
+    }
+#endif
+    copyBlock(src, m, dst, dstStride, x0, y, w, y0 + h - y);
+  }
+
+  void transform(const uchar *src, const Mapping& m,
+                 uchar *dst, const qptrdiff dstStride,
+                 const int width, const int height)
+  {
+    if( !m.transposed ) {
+      for( int y = 0; y < height; y++ ) {
+        if( m.stepX == 4 ) {
+          std::memcpy(dst + qptrdiff(y) * dstStride, src + m.start + qptrdiff(y) * m.stepY,
+                      std::size_t(width) * 4);
+        } else {
+          copyBlock(src, m, dst, dstStride, 0, y, width, 1);
+        }
+      }
+      return;
+    }
+
+    for( int ty = 0; ty < height; ty += TILE ) {
+      const int th = std::min<int>(TILE, height - ty);
+      for( int tx = 0; tx < width; tx += TILE ) {
+        const int tw = std::min<int>(TILE, width - tx);
+        transposeTile(src, m, dst, dstStride, tx, ty, tw, th);
+      }
+    }
+  }
+
+} // namespace impl
+
+////// public ////////////////////////////////////////////////////////////////
+
+namespace util {
+
+  QImage rotated(const QImage& image, const int angle)
+  {
+    return transformed(image, angle, false, false);
+  }
+
+  QImage transformed(const QImage& image, const int angle,
+                     const bool flipH, const bool flipV)
+  {
+    TRACE("util::transformed");
+
+    const int rot = angle == 90 || angle == 180 || angle == 270
+                    ? angle
+                    : 0;
+    if( image.isNull() || (rot == 0 && !flipH && !flipV) ) {
+      return image;
+    }
+
+    const QImage src = image.depth() == 32
+                       ? image
+                       : image.convertToFormat(image.hasAlphaChannel()
+                                               ? QImage::Format_ARGB32_Premultiplied
+                                               : QImage::Format_RGB32);
+
+    const bool is_transposed = rot == 90 || rot == 270;
+
+    QImage dst(is_transposed ? src.height() : src.width(),
+               is_transposed ? src.width() : src.height(),
+               src.format());
+    if( dst.isNull() ) {
+      return QImage();
+    }
+    dst.setDotsPerMeterX(is_transposed ? src.dotsPerMeterY() : src.dotsPerMeterX());
+    dst.setDotsPerMeterY(is_transposed ? src.dotsPerMeterX() : src.dotsPerMeterY());
+
+    impl::transform(src.constBits(), impl::mapping(src, rot, flipH, flipV),
+                    dst.bits(), dst.bytesPerLine(),
+                    dst.width(), dst.height());
 
-    QMatrix matrix{COS, -SIN,
-                  SIN, COS,
-                  0, 0};
-    return image.transformed(matrix, Qt::SmoothTransformation);
+    return dst;
   }
 
 } // namespace util
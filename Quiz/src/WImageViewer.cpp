@@ -29,13 +29,33 @@
 ** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 *****************************************************************************/
 
+#include <algorithm>
+#include <cstdlib>
 #include <iterator>
 
+#include <QtCore/QSettings>
+#include <QtCore/QTimer>
+#include <QtGui/QGuiApplication>
 #include <QtGui/QKeyEvent>
 #include <QtGui/QPainter>
+#include <QtGui/QScreen>
 
 #include "wimageviewer.h"
 
+#include "ImageLoader.h"
+
+#include "Trace.h"
+
+////// Private ///////////////////////////////////////////////////////////////
+
+namespace impl {
+
+  const QString PREFETCH_AHEAD_KEY  = QStringLiteral("viewer/prefetchAhead");
+  const QString PREFETCH_BEHIND_KEY = QStringLiteral("viewer/prefetchBehind");
+  const QString PREFETCH_MIB_KEY    = QStringLiteral("viewer/prefetchMiB");
+
+} // namespace impl
+
 ////// public ////////////////////////////////////////////////////////////////
 
 WImageViewer::WImageViewer(const Images& images, QWidget *parent, Qt::WindowFlags f)
@@ -47,6 +67,20 @@ WImageViewer::WImageViewer(const Images& images, QWidget *parent, Qt::WindowFlag
   }
   setAttribute(Qt::WA_OpaquePaintEvent, true);
 
+  _smoothTimer = new QTimer(this);
+  _smoothTimer->setInterval(150);
+  _smoothTimer->setSingleShot(true);
+  connect(_smoothTimer, &QTimer::timeout, this, QOverload<>::of(&WImageViewer::update));
+
+  _loader = new ImageLoader(this);
+  _loader->setTargetSize(displaySize());
+  connect(_loader, &ImageLoader::loaded, this, &WImageViewer::imageLoaded);
+
+  const QSettings settings(QStringLiteral("Quiz"), QStringLiteral("Quiz"));
+  _prefetchAhead  = std::max<int>(0, settings.value(impl::PREFETCH_AHEAD_KEY, _prefetchAhead).toInt());
+  _prefetchBehind = std::max<int>(0, settings.value(impl::PREFETCH_BEHIND_KEY, _prefetchBehind).toInt());
+  _prefetchBytes  = std::max<qint64>(0, settings.value(impl::PREFETCH_MIB_KEY, _prefetchBytes >> 20).toLongLong()) << 20;
+
   _pos = _images.cbegin();
   updateImage();
 }
@@ -55,8 +89,31 @@ WImageViewer::~WImageViewer()
 {
 }
 
+void WImageViewer::setSmoothDelay(const int msecs)
+{
+  _smoothTimer->stop();
+  _smoothTimer->setInterval(std::max<int>(0, msecs));
+}
+
+QSize WImageViewer::displaySize()
+{
+  const QScreen *screen = QGuiApplication::primaryScreen();
+  return screen != nullptr
+         ? screen->size() * screen->devicePixelRatio()
+         : QSize();
+}
+
 ////// protected /////////////////////////////////////////////////////////////
 
+void WImageViewer::closeEvent(QCloseEvent *event)
+{
+  _frames.clear();
+  _loader->setWindow(0, -1);
+  _scaled = QImage();
+
+  QWidget::closeEvent(event);
+}
+
 void WImageViewer::keyPressEvent(QKeyEvent *event)
 {
   if( event->key() == Qt::Key_Escape ) {
@@ -78,6 +135,8 @@ void WImageViewer::keyPressEvent(QKeyEvent *event)
 
 void WImageViewer::paintEvent(QPaintEvent * /*event*/)
 {
+  TRACE("WImageViewer::paintEvent");
+
   QPainter painter(this);
   painter.fillRect(0, 0, width(), height(), _bgColor);
 
@@ -85,15 +144,53 @@ void WImageViewer::paintEvent(QPaintEvent * /*event*/)
     return;
   }
 
-  const QImage image = _image.scaled(size(), Qt::KeepAspectRatio, Qt::SmoothTransformation);
-  const int offx     = (width() - image.width()) / 2;
-  const int offy     = (height() - image.height()) / 2;
+  const bool is_resizing = _smoothTimer->isActive();
+  if( _scaled.isNull()
+      || _scaledSize != size()
+      || _scaledDpr != devicePixelRatioF()
+      || (!_scaledSmooth && !is_resizing) ) {
+    scaleImage(is_resizing
+               ? Qt::FastTransformation
+               : Qt::SmoothTransformation);
+  }
 
-  painter.drawImage(offx, offy, image);
+  const qreal offx = (qreal(width()) - qreal(_scaled.width()) / _scaledDpr) / 2.0;
+  const qreal offy = (qreal(height()) - qreal(_scaled.height()) / _scaledDpr) / 2.0;
+
+  painter.drawImage(QPointF(offx, offy), _scaled);
+}
+
+void WImageViewer::resizeEvent(QResizeEvent *event)
+{
+  if( _smoothTimer->interval() > 0 ) {
+    _smoothTimer->start();
+  }
+
+  QWidget::resizeEvent(event);
+}
+
+////// private slots /////////////////////////////////////////////////////////
+
+void WImageViewer::imageLoaded(int id, const QImage& image)
+{
+  if( isEmpty() ) {
+    return;
+  }
+
+  storeFrame(id, image);
+
+  if( id == index() ) {
+    setImage(image);
+  }
 }
 
 ////// private ///////////////////////////////////////////////////////////////
 
+int WImageViewer::index() const
+{
+  return int(std::distance(_images.cbegin(), _pos));
+}
+
 bool WImageViewer::isBegin() const
 {
   return _pos == _images.cbegin();
@@ -104,15 +201,114 @@ bool WImageViewer::isEmpty() const
   return _images.empty();
 }
 
+void WImageViewer::loadImages()
+{
+  const int cur   = index();
+  const int first = std::max<int>(0, cur - _prefetchBehind);
+  const int last  = std::min<int>(int(_images.size()) - 1, cur + _prefetchAhead);
+
+  _loader->setWindow(first, last);
+
+  // (1) Drop frames outside the window //////////////////////////////////////
+
+  for( auto it = _frames.begin(); it != _frames.end(); ) {
+    if( it.key() < first || it.key() > last ) {
+      it = _frames.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  // (2) Current image; ahead of any prefetching /////////////////////////////
+
+  if( _frames.contains(cur) ) {
+    setImage(_frames.value(cur));
+  } else {
+    _loader->request(cur, *_pos, 1);
+  }
+
+  // (3) Prefetch; nearest first /////////////////////////////////////////////
+
+  for( int dist = 1; dist <= std::max<int>(_prefetchAhead, _prefetchBehind); dist++ ) {
+    for( const int id : {cur + dist, cur - dist} ) {
+      if( id < first || id > last || _frames.contains(id) ) {
+        continue;
+      }
+      _loader->request(id, *std::next(_images.cbegin(), id));
+    }
+  }
+}
+
+void WImageViewer::scaleImage(const Qt::TransformationMode mode)
+{
+  TRACE("WImageViewer::scaleImage");
+
+  _scaledDpr    = devicePixelRatioF();
+  _scaledSize   = size();
+  _scaledSmooth = mode == Qt::SmoothTransformation;
+
+  const QImage::Format format = _image.hasAlphaChannel()
+                                ? QImage::Format_ARGB32_Premultiplied
+                                : QImage::Format_RGB32;
+
+  _scaled = _image
+              .scaled(size() * _scaledDpr, Qt::KeepAspectRatio, mode)
+              .convertToFormat(format);
+  _scaled.setDevicePixelRatio(_scaledDpr);
+}
+
+void WImageViewer::setImage(const QImage& image)
+{
+  _image  = image;
+  _scaled = QImage();
+  update();
+}
+
+void WImageViewer::storeFrame(const int id, const QImage& image)
+{
+  if( image.isNull() ) {
+    return;
+  }
+
+  const int cur = index();
+  if( id < cur - _prefetchBehind || id > cur + _prefetchAhead ) {
+    return;
+  }
+
+  _frames.insert(id, image);
+
+  const auto bytes = [this]() -> qint64 {
+    qint64 sum = 0;
+    for( const QImage& frame : qAsConst(_frames) ) {
+      sum += frame.sizeInBytes();
+    }
+    return sum;
+  };
+
+  while( bytes() > _prefetchBytes ) {
+    auto victim = _frames.end();
+    for( auto it = _frames.begin(); it != _frames.end(); ++it ) {
+      if( it.key() != cur
+          && (victim == _frames.end() || std::abs(it.key() - cur) > std::abs(victim.key() - cur)) ) {
+        victim = it;
+      }
+    }
+    if( victim == _frames.end() ) {
+      break;
+    }
+    _frames.erase(victim);
+  }
+}
+
 void WImageViewer::updateImage()
 {
+  TRACE("WImageViewer::updateImage");
+
   if( !isEmpty() ) {
     QString title;
     title += QStringLiteral("Image");
     if( _images.size() > 1 ) {
-      const auto i = std::distance(_images.cbegin(), _pos);
-
-      title += QStringLiteral(" %1 of %2").arg(i + 1).arg(_images.size());
+      title += QStringLiteral(" %1 of %2").arg(index() + 1).arg(_images.size());
     }
     title += QStringLiteral(" - [%1]").arg(_pos->fileName());
     setWindowTitle(title);
@@ -122,7 +318,7 @@ void WImageViewer::updateImage()
       _bgColor = Qt::black;
     }
 
-    _image = _pos->load();
+    loadImages();
   } else {
     setWindowTitle(QStringLiteral("No Image"));
 
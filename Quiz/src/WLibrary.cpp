@@ -0,0 +1,180 @@
+/****************************************************************************
+** Copyright (c) 2023, Carsten Schmidt. All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+**
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+**
+** 3. Neither the name of the copyright holder nor the names of its
+**    contributors may be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+** "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+** LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+** A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+** HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+** SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+** LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*****************************************************************************/
+
+#include <QtConcurrent/QtConcurrentRun>
+#include <QtCore/QDir>
+#include <QtCore/QSettings>
+#include <QtCore/QSortFilterProxyModel>
+#include <QtWidgets/QFileDialog>
+
+#include "WLibrary.h"
+#include "ui_WLibrary.h"
+
+#include "LibraryModel.h"
+
+////// Private ///////////////////////////////////////////////////////////////
+
+namespace impl {
+
+  const QString ROOT_KEY = QStringLiteral("library/root");
+
+} // namespace impl
+
+////// public ////////////////////////////////////////////////////////////////
+
+WLibrary::WLibrary(QWidget *parent, Qt::WindowFlags f)
+  : QDialog(parent, f)
+  , ui(new Ui::WLibrary)
+{
+  ui->setupUi(this);
+
+  // Setup UI ////////////////////////////////////////////////////////////////
+
+  _model = new LibraryModel(this);
+
+  _proxy = new QSortFilterProxyModel(this);
+  _proxy->setFilterCaseSensitivity(Qt::CaseInsensitive);
+  _proxy->setFilterKeyColumn(-1);
+  _proxy->setSortCaseSensitivity(Qt::CaseInsensitive);
+  _proxy->setSortRole(LibraryModel::SortRole);
+  _proxy->setSourceModel(_model);
+
+  ui->libraryView->setModel(_proxy);
+  ui->libraryView->sortByColumn(LibraryModel::FileColumn, Qt::AscendingOrder);
+
+  _watcher = new QFutureWatcher<Scan>(this);
+
+  // Signals & Slots /////////////////////////////////////////////////////////
+
+  connect(ui->buttonBox, &QDialogButtonBox::accepted, this, &WLibrary::openCurrent);
+  connect(ui->filterEdit, &QLineEdit::textChanged,
+          _proxy, &QSortFilterProxyModel::setFilterFixedString);
+  connect(ui->folderButton, &QPushButton::clicked, this, &WLibrary::chooseFolder);
+  connect(ui->libraryView, &QTableView::activated, this, &WLibrary::openCurrent);
+  connect(ui->rescanButton, &QPushButton::clicked, this, &WLibrary::rescan);
+  connect(_watcher, &QFutureWatcher<Scan>::finished, this, &WLibrary::scanFinished);
+
+  // Last Library ////////////////////////////////////////////////////////////
+
+  const QSettings settings(QStringLiteral("Quiz"), QStringLiteral("Quiz"));
+  const QString root = settings.value(impl::ROOT_KEY).toString();
+  if( !root.isEmpty() ) {
+    setRootPath(root);
+  } else {
+    showStatus(tr("No folder"));
+  }
+}
+
+WLibrary::~WLibrary()
+{
+  delete ui;
+}
+
+QString WLibrary::rootPath() const
+{
+  return _rootPath;
+}
+
+void WLibrary::setRootPath(const QString& path)
+{
+  _rootPath = path;
+  QSettings settings(QStringLiteral("Quiz"), QStringLiteral("Quiz"));
+  settings.setValue(impl::ROOT_KEY, _rootPath);
+
+  setWindowTitle(tr("Library - [%1]").arg(QDir::toNativeSeparators(_rootPath)));
+
+  _model->setEntries(_rootPath, library::readIndex(_rootPath));
+
+  rescan();
+}
+
+////// private slots /////////////////////////////////////////////////////////
+
+void WLibrary::chooseFolder()
+{
+  const QString path = QFileDialog::getExistingDirectory(this, tr("Library"), _rootPath);
+  if( !path.isEmpty() ) {
+    setRootPath(path);
+  }
+}
+
+void WLibrary::openCurrent()
+{
+  const QModelIndex index = _proxy->mapToSource(ui->libraryView->currentIndex());
+  const LibraryEntry entry = _model->entry(index.row());
+  if( entry.path.isEmpty() || !entry.isValid() ) {
+    return;
+  }
+
+  emit quizSelected(entry.path);
+  accept();
+}
+
+void WLibrary::rescan()
+{
+  if( _rootPath.isEmpty() ) {
+    return;
+  }
+
+  ui->rescanButton->setEnabled(false);
+  showStatus(tr("Scanning..."));
+
+  _watcher->setFuture(QtConcurrent::run([root = _rootPath, known = _model->entries()]() -> Scan {
+    Scan scan;
+    scan.entries  = library::scan(root, known, &scan.parsed);
+    scan.rootPath = root;
+    if( scan.parsed > 0 || scan.entries.size() != known.size() ) {
+      library::writeIndex(root, scan.entries);
+    }
+    return scan;
+  }));
+}
+
+void WLibrary::scanFinished()
+{
+  ui->rescanButton->setEnabled(true);
+
+  const Scan scan = _watcher->result();
+  if( scan.rootPath != _rootPath ) {
+    return;
+  }
+
+  _model->setEntries(scan.rootPath, scan.entries);
+
+  showStatus(tr("%1 updated").arg(scan.parsed));
+}
+
+////// private ///////////////////////////////////////////////////////////////
+
+void WLibrary::showStatus(const QString& what)
+{
+  ui->statusLabel->setText(tr("%1 quizzes; %2").arg(_model->rowCount()).arg(what));
+}
@@ -29,12 +29,37 @@
 ** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 *****************************************************************************/
 
+#include <algorithm>
+#include <utility>
+
+#include <QtCore/QFileInfo>
+#include <QtCore/QFileSystemWatcher>
+#include <QtCore/QHash>
+#include <QtCore/QSettings>
+#include <QtCore/QTimer>
 #include <QtWidgets/QFileDialog>
+#include <QtWidgets/QMessageBox>
 
 #include "wmainwindow.h"
 #include "ui_wmainwindow.h"
 
+#include "DocumentCache.h"
+#include "ImageCache.h"
+#include "ImageWarmup.h"
 #include "questionsmodel.h"
+#include "WImageViewer.h"
+#include "WLibrary.h"
+#include "WQuestion.h"
+
+#include "Trace.h"
+
+////// Private ///////////////////////////////////////////////////////////////
+
+namespace impl {
+
+  const QString JOURNAL_SYNC_KEY = QStringLiteral("journal/sync");
+
+} // namespace impl
 
 ////// public ////////////////////////////////////////////////////////////////
 
@@ -46,18 +71,87 @@ WMainWindow::WMainWindow(QWidget *parent, Qt::WindowFlags flags)
 
   // Initialization //////////////////////////////////////////////////////////
 
+  _documentCache = new DocumentCache(this);
+
+  _questionDialog = new WQuestion(this);
+  _questionDialog->resize(800, 600);
+
+  _documentCache->setTextWidth(_questionDialog->textWidth());
+
   _questionsModel = new QuestionsModel(ui->questionsView);
+  _questionsModel->setDocumentCache(_documentCache);
+  _questionsModel->setQuestionDialog(_questionDialog);
   ui->questionsView->setModel(_questionsModel);
 
+  _imageWarmup = new ImageWarmup(this);
+
+  _fileWatcher = new QFileSystemWatcher(this);
+
+  _reloadTimer = new QTimer(this);
+  _reloadTimer->setInterval(250);
+  _reloadTimer->setSingleShot(true);
+
   // Signals & Slots /////////////////////////////////////////////////////////
 
   connect(ui->questionsView, &QListView::activated,
           _questionsModel, &QuestionsModel::activate);
   connect(_questionsModel, &QuestionsModel::uncovered,
           this, &WMainWindow::uncover);
+  connect(_questionsModel, &QuestionsModel::answered, this, [this](const QChar& c) -> void {
+    _journal.record(Journal::Answer, c);
+    if( isFinished() ) {
+      _journal.remove();
+    }
+  });
+
+  connect(ui->journalSyncAction, &QAction::toggled, this, [this](bool checked) -> void {
+    _journal.setSync(checked
+                     ? Journal::SyncAlways
+                     : Journal::SyncNone);
+    QSettings settings(QStringLiteral("Quiz"), QStringLiteral("Quiz"));
+    settings.setValue(impl::JOURNAL_SYNC_KEY, checked);
+  });
+
+  connect(ui->keepAnsweredAction, &QAction::toggled,
+          _questionsModel, &QuestionsModel::setKeepAnswered);
 
+  connect(_imageWarmup, &ImageWarmup::progress, this, [this](int done, int total) -> void {
+    ui->statusbar->showMessage(tr("Warming up images... %1/%2").arg(done).arg(total));
+  });
+  connect(_imageWarmup, &ImageWarmup::finished, this, [this](int count, int failed, int cached) -> void {
+    ui->statusbar->showMessage(tr("%1 images ready (%2 cached), %3 failed.")
+                               .arg(count - failed).arg(cached).arg(failed), 5000);
+  });
+  connect(ui->warmupAction, &QAction::toggled, this, [this](bool checked) -> void {
+    if( checked ) {
+      _imageWarmup->start(_quiz, WImageViewer::displaySize());
+    } else {
+      _imageWarmup->cancel();
+      ui->statusbar->clearMessage();
+    }
+  });
+
+  connect(_fileWatcher, &QFileSystemWatcher::fileChanged, this, &WMainWindow::fileChanged);
+  connect(_reloadTimer, &QTimer::timeout, this, &WMainWindow::reload);
+  connect(ui->reloadAction, &QAction::toggled, this, [this](bool checked) -> void {
+    if( checked ) {
+      watchFiles();
+    } else {
+      _reloadTimer->stop();
+      if( !_fileWatcher->files().isEmpty() ) {
+        _fileWatcher->removePaths(_fileWatcher->files());
+      }
+    }
+  });
+
+  connect(ui->libraryAction, &QAction::triggered, this, &WMainWindow::openLibrary);
   connect(ui->openAction, &QAction::triggered, this, &WMainWindow::open);
   connect(ui->quitAction, &QAction::triggered, this, &WMainWindow::close);
+
+  // Settings ////////////////////////////////////////////////////////////////
+
+  const QSettings settings(QStringLiteral("Quiz"), QStringLiteral("Quiz"));
+  ui->journalSyncAction->setChecked(settings.value(impl::JOURNAL_SYNC_KEY, false).toBool());
 }
 
 WMainWindow::~WMainWindow()
@@ -69,34 +163,291 @@ WMainWindow::~WMainWindow()
 
 void WMainWindow::open()
 {
-  const QString filename = QFileDialog::getOpenFileName(this, tr("Open"), QString(), tr("Quiz (*.xml)"));
+  const QString filename = QFileDialog::getOpenFileName(this, tr("Open"), QString(), tr("Quiz (*.xml *.qzb *.quizpack)"));
   if( filename.isEmpty() ) {
     return;
   }
-  const Quiz q = Quiz::read(filename);
+  openFile(filename);
+}
+
+void WMainWindow::openFile(const QString& filename)
+{
+  QString errmsg;
+  const Quiz q = Quiz::load(filename, &errmsg);
   if( q.isEmpty() ) {
+    if( !errmsg.isEmpty() ) {
+      QMessageBox::critical(this, tr("Error"), errmsg);
+    }
     return;
   }
+
+  _journal.close();
+
+  const QList<Journal::Entry> entries = Journal::read(filename, q);
+  const bool resume = !entries.isEmpty()
+                      && QMessageBox::question(this, tr("Resume"),
+                                               tr("Resume the previous game of this quiz (%n action(s))?",
+                                                  nullptr, entries.size()),
+                                               QMessageBox::Yes | QMessageBox::No,
+                                               QMessageBox::Yes) == QMessageBox::Yes;
+
+  _changedImages.clear();
+  _filename    = filename;
+  _quizChanged = false;
+  _reloadTimer->stop();
+
   setupQuiz(q);
+  if( resume ) {
+    replay(entries);
+  }
+
+  if( !_journal.open(_filename, _quiz, resume) ) {
+    ui->statusbar->showMessage(tr("Unable to write journal %1!").arg(Journal::fileName(_filename)), 5000);
+  }
+
+  watchFiles();
+}
+
+void WMainWindow::openLibrary()
+{
+  if( _library == nullptr ) {
+    _library = new WLibrary(this);
+    _library->resize(900, 600);
+    connect(_library, &WLibrary::quizSelected, this, &WMainWindow::openFile);
+  }
+
+  _library->show();
+  _library->raise();
+  _library->activateWindow();
+
+  if( _library->rootPath().isEmpty() ) {
+    QMetaObject::invokeMethod(_library, "chooseFolder", Qt::QueuedConnection);
+  }
 }
 
 void WMainWindow::uncover(const QChar& c)
 {
-  ui->solutionEdit->setText(_quiz.solve(c));
+  QVector<int> changed;
+  const QString text = _quiz.solve(c, &changed);
+  if( !changed.isEmpty() ) {
+    ui->solutionEdit->setText(text);
+    _journal.record(Journal::Reveal, c);
+  }
+}
+
+////// private slots /////////////////////////////////////////////////////////
+
+void WMainWindow::fileChanged(const QString& path)
+{
+  if( path == _filename ) {
+    _quizChanged = true;
+  } else {
+    _changedImages.insert(path);
+  }
+  _reloadTimer->start();
+}
+
+void WMainWindow::reload()
+{
+  if( _questionDialog->isVisible()
+      || (_quizChanged && !QFileInfo::exists(_filename)) ) {
+    _reloadTimer->start();
+    return;
+  }
+
+  TRACE("WMainWindow::reload");
+
+  const QSet<QString> changedImages = std::exchange(_changedImages, QSet<QString>());
+
+  // (1) Quiz ////////////////////////////////////////////////////////////////
+
+  Quiz fresh;
+  if( std::exchange(_quizChanged, false) ) {
+    QString errmsg;
+    fresh = Quiz::load(_filename, &errmsg);
+    if( fresh.isEmpty() ) {
+      ui->statusbar->showMessage(tr("Reload failed: %1").arg(errmsg), 5000);
+      watchFiles();
+      return;
+    }
+  } else {
+    fresh = _quiz;
+    for( Question& q : fresh.questions ) {
+      for( Image& image : q.images ) {
+        if( changedImages.contains(image.path) ) {
+          image.refresh();
+        }
+      }
+    }
+  }
+
+  // (2) Revealed letters ////////////////////////////////////////////////////
+
+  if( fresh.solution == _quiz.solution ) {
+    fresh.displayText = _quiz.displayText;
+  } else {
+    const int len = std::min<int>(_quiz.displayText.size(), _quiz.solution.size());
+    for( int i = 0; i < len; i++ ) {
+      if( _quiz.solution[i].isLetter() && _quiz.displayText[i] == _quiz.solution[i] ) {
+        fresh.solve(_quiz.solution[i]);
+      }
+    }
+  }
+
+  // (3) Evict changed images ////////////////////////////////////////////////
+
+  QHash<QString,qint64> fileTimes;
+  for( const Question& q : qAsConst(_quiz.questions) ) {
+    for( const Image& image : q.images ) {
+      fileTimes.insert(image.path, image.fileTime);
+    }
+  }
+
+  QSet<QString> evicted;
+  for( const Question& q : qAsConst(fresh.questions) ) {
+    for( const Image& image : q.images ) {
+      const auto hit = fileTimes.constFind(image.path);
+      if( evicted.contains(image.path)
+          || (!changedImages.contains(image.path)
+              && (hit == fileTimes.cend() || hit.value() == image.fileTime)) ) {
+        continue;
+      }
+      ImageCache::instance().evict(image.path);
+      evicted.insert(image.path);
+    }
+  }
+
+  // (4) Apply ///////////////////////////////////////////////////////////////
+
+  const bool is_new_solution = fresh.solution != _quiz.solution;
+
+  _quiz = fresh;
+
+  _questionsModel->updateQuestions(_quiz);
+  _documentCache->updateQuiz(_quiz);
+  setupSolution();
+
+  if( is_new_solution ) {
+    restartJournal();
+  }
+
+  if( !evicted.isEmpty() && ui->warmupAction->isChecked() ) {
+    _imageWarmup->start(_quiz, WImageViewer::displaySize());
+  }
+
+  watchFiles();
+
+  ui->statusbar->showMessage(tr("Reloaded."), 3000);
 }
 
 ////// private ///////////////////////////////////////////////////////////////
 
+bool WMainWindow::isFinished() const
+{
+  return !_quiz.questions.isEmpty()
+         && _questionsModel->answeredLetters().size() >= _quiz.questions.size();
+}
+
+void WMainWindow::replay(const QList<Journal::Entry>& entries)
+{
+  for( const Journal::Entry& e : entries ) {
+    if(        e.action == Journal::Reveal ) {
+      _quiz.solve(e.letter);
+    } else if( e.action == Journal::Answer ) {
+      _questionsModel->setAnsweredLetter(e.letter);
+    }
+  }
+
+  setupSolution();
+}
+
+void WMainWindow::restartJournal()
+{
+  if( isFinished() ) {
+    _journal.remove();
+    return;
+  }
+
+  if( !_journal.open(_filename, _quiz, false) ) {
+    return;
+  }
+
+  QSet<QChar> revealed;
+  const int len = std::min<int>(_quiz.displayText.size(), _quiz.solution.size());
+  for( int i = 0; i < len; i++ ) {
+    if( _quiz.solution[i].isLetter() && _quiz.displayText[i] == _quiz.solution[i] ) {
+      revealed.insert(_quiz.solution[i]);
+    }
+  }
+
+  for( const QChar& c : qAsConst(revealed) ) {
+    _journal.record(Journal::Reveal, c);
+  }
+  for( const QChar& c : _questionsModel->answeredLetters() ) {
+    _journal.record(Journal::Answer, c);
+  }
+}
+
 void WMainWindow::setupQuiz(const Quiz& quiz)
 {
   _quiz = quiz;
 
   _questionsModel->setQuestions(_quiz);
+  _documentCache->setQuiz(_quiz);
+
+  setupSolution();
+
+  if( ui->warmupAction->isChecked() ) {
+    _imageWarmup->start(_quiz, WImageViewer::displaySize());
+  }
+}
+
+void WMainWindow::setupSolution()
+{
+  if( ui->solutionEdit->text() != _quiz.displayText ) {
+    ui->solutionEdit->setText(_quiz.displayText);
+  }
 
-  ui->solutionEdit->setText(_quiz.displayText);
   QFont f = ui->solutionEdit->font();
   f.setBold(true);
   f.setLetterSpacing(QFont::AbsoluteSpacing, 16.0);
   f.setPointSize(_quiz.fontSize);
   ui->solutionEdit->setFont(f);
 }
+
+void WMainWindow::watchFiles()
+{
+  if( !ui->reloadAction->isChecked() || _filename.isEmpty() ) {
+    return;
+  }
+
+  QSet<QString> paths;
+  paths.insert(_filename);
+  for( const Question& q : qAsConst(_quiz.questions) ) {
+    for( const Image& image : q.images ) {
+      if( !image.pack ) {
+        paths.insert(image.path);
+      }
+    }
+  }
+
+  QStringList obsolete;
+  for( const QString& path : _fileWatcher->files() ) {
+    if( !paths.remove(path) ) {
+      obsolete.push_back(path);
+    }
+  }
+  if( !obsolete.isEmpty() ) {
+    _fileWatcher->removePaths(obsolete);
+  }
+
+  QStringList added;
+  for( const QString& path : qAsConst(paths) ) {
+    if( QFileInfo::exists(path) ) {
+      added.push_back(path);
+    }
+  }
+  if( !added.isEmpty() ) {
+    _fileWatcher->addPaths(added);
+  }
+}
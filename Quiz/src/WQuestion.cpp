@@ -29,34 +29,15 @@
 ** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 *****************************************************************************/
 
+#include <QtGui/QTextDocument>
+#include <QtWidgets/QLayout>
+
 #include "wquestion.h"
 #include "ui_wquestion.h"
 
-////// Private ///////////////////////////////////////////////////////////////
-
-namespace impl {
-
-  void setupDocument(QTextDocument *doc, const bool font_bold, const int font_size)
-  {
-    doc->clear();
-
-    // (1) Font //////////////////////////////////////////////////////////////
-
-    QFont font = doc->defaultFont();
-    font.setBold(font_bold);
-    if( font_size > 0 ) {
-      font.setPointSize(font_size);
-    }
-    doc->setDefaultFont(font);
-
-    // (2) Layout ////////////////////////////////////////////////////////////
-
-    QTextOption opt = doc->defaultTextOption();
-    opt.setAlignment(Qt::AlignCenter);
-    doc->setDefaultTextOption(opt);
-  }
+#include "DocumentCache.h"
 
-} // namespace impl
+#include "Trace.h"
 
 ////// public ////////////////////////////////////////////////////////////////
 
@@ -68,6 +49,8 @@ WQuestion::WQuestion(QWidget *parent, Qt::WindowFlags f)
 
   // Setup UI ////////////////////////////////////////////////////////////////
 
+  _blank = new QTextDocument(this);
+
   enableOk(false);
 
   // Signals & Slots /////////////////////////////////////////////////////////
@@ -79,25 +62,65 @@ WQuestion::~WQuestion()
 {
 }
 
-void WQuestion::setQuestion(const int fontSize, const Question& q)
+void WQuestion::done(int r)
 {
+  ui->answerBrowser->setDocument(_blank);
+  ui->questionBrowser->setDocument(_blank);
+
+  _docs     = nullptr;
+  _question = nullptr;
+
+  QDialog::done(r);
+}
+
+// The cache owns the documents; never clear() or setHtml() the browsers!
+void WQuestion::setQuestion(const Question& q, DocumentCache *docs)
+{
+  TRACE("WQuestion::setQuestion");
+
   enableOk(false);
-  ui->answerBrowser->clear();
-  ui->questionBrowser->clear();
 
-  _fontSize = fontSize;
-  _question = q;
+  _docs     = docs;
+  _question = &q;
 
-  impl::setupDocument(ui->questionBrowser->document(), true, _fontSize);
-  ui->questionBrowser->setHtml(_question.question);
+  ui->answerBrowser->setDocument(_blank);
+  ui->questionBrowser->setDocument(_docs->question(*_question));
+}
+
+int WQuestion::textWidth()
+{
+  if( isVisible() ) {
+    return ui->questionBrowser->viewport()->width();
+  }
+
+  ensurePolished();
+  if( layout() != nullptr ) {
+    layout()->invalidate();
+    layout()->activate();
+  }
+  return ui->questionBrowser->contentsRect().width();
+}
+
+////// protected /////////////////////////////////////////////////////////////
+
+void WQuestion::showEvent(QShowEvent *event)
+{
+  if( _docs != nullptr ) {
+    _docs->setTextWidth(textWidth());
+  }
+
+  QDialog::showEvent(event);
 }
 
 ////// private slots /////////////////////////////////////////////////////////
 
 void WQuestion::showAnswer()
 {
-  impl::setupDocument(ui->answerBrowser->document(), true, _fontSize);
-  ui->answerBrowser->setHtml(_question.answer);
+  if( _docs == nullptr || _question == nullptr ) {
+    return;
+  }
+
+  ui->answerBrowser->setDocument(_docs->answer(*_question));
 
   enableOk(true);
 }
@@ -29,31 +29,27 @@
 ** OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 *****************************************************************************/
 
-#include <cstdio>
 #include <cstdlib>
 
 #include <QtWidgets/QApplication>
 
-#include "data.h"
+#include "Commands.h"
+#include "Trace.h"
 #include "wmainwindow.h"
 
-void generateXml(const QString& solution)
-{
-  const Quiz q(solution);
-  if( q.isEmpty() ) {
-    return;
-  }
-  q.write(QStringLiteral("output.xml"));
-}
-
 int main(int argc, char **argv)
 {
   QApplication app(argc, argv);
 
-  const QStringList args = QApplication::arguments();
-  if( args.size() == 3 && args[1] == QStringLiteral("-generate") ) {
-    generateXml(args[2]);
-    return EXIT_SUCCESS;
+  QStringList args = QApplication::arguments();
+  trace::setup(args);
+
+  if( args.size() > 1 && args[1].startsWith(QChar::fromLatin1('-')) &&
+      commands::isCommand(args[1].mid(1)) ) {
+    args[1].remove(0, 1);
+    return commands::run(args.mid(1))
+           ? EXIT_SUCCESS
+           : EXIT_FAILURE;
   }
 
   WMainWindow *w = new WMainWindow();